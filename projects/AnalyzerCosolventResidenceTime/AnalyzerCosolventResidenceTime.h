@@ -0,0 +1,394 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2018,2021 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers (Ron Dockhorn)
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef AnalyzerCosolventResidenceTime_H
+#define AnalyzerCosolventResidenceTime_H
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "MonomerIndexLattice.h"
+#include "ChainBridgeEngine.h"
+#include "IntegerHistogram.h"
+#include "MultiTauCorrelator.h"
+
+// polymere attribute tag = 1
+// solvent attribute tag = 2
+// cosolvemt attribute tag = 3
+
+/*****************************************************************************/
+/**
+ * @class AnalyzerCosolventResidenceTime
+ * @brief residence times of the cosolvent in the NN-shell of the polymer and lifetimes of contacts and bridges
+ * @details The contacts (diff*diff <= 6) of every cosolvent are found with the
+ * monomer index lattice and bridges are classified by the ChainBridgeEngine, as
+ * in AnalyzerCounterNNShellBridges. The contacts of a frame are kept as sorted
+ * array of (cosolvent, polymer monomer) keys, so the contacts that ended and
+ * started since the last frame are found by one merge of the arrays of both
+ * frames. Residence times (cosolvent in the shell, cosolvent as bridge, single
+ * contact) are counted in frames when they end; intervals that were already
+ * open at the first analysed frame are not counted, intervals still open at the
+ * end are reported in the header. The indicator functions of shell and bridge
+ * are correlated with a multiple-tau correlator, which gives the intermittent
+ * survival function <h(0)h(t)>/<h> with memory independent of the trajectory
+ * length. All times are in analysed frames, the MCS columns use the mean frame
+ * interval.
+ * */
+/*****************************************************************************/
+template <class IngredientsType>
+class AnalyzerCosolventResidenceTime : public AbstractAnalyzer
+{
+public:
+	AnalyzerCosolventResidenceTime(const IngredientsType &ing, uint64_t startTime_, std::string dstDir_,
+	                               uint32_t minContourSpan_ = 5, uint32_t maxResidenceTime_ = 1000, uint32_t numCorrelatorLevels_ = 16);
+
+	virtual ~AnalyzerCosolventResidenceTime(){
+
+	};
+
+	const IngredientsType &getIngredients() const { return ingredients; }
+
+	virtual void initialize();
+	virtual bool execute();
+	virtual void cleanup();
+
+private:
+	//! start frame of an interval that was open at the first analysed frame
+	static const uint32_t censored = uint32_t(-1);
+
+	const IngredientsType &ingredients;
+
+	uint64_t startTime;
+
+	std::string dstdir;
+
+	//! histograms have bins 0..maxResidenceTime frames
+	uint32_t maxResidenceTime;
+
+	uint32_t numCorrelatorLevels;
+
+	MonomerIndexLattice polymerLattice;
+
+	ChainBridgeEngine bridgeEngine;
+
+	//! monomer indices of the cosolvent, fixed in initialize()
+	std::vector<uint32_t> cosolvent;
+
+	//! (cosolvent number << 32 | polymer monomer) of the contacts of the last frame, ascending, and the frame they started
+	std::vector<uint64_t> contactKeys;
+	std::vector<uint32_t> contactStart;
+
+	//! the same for the current frame, swapped with the above after the diff
+	std::vector<uint64_t> newContactKeys;
+	std::vector<uint32_t> newContactStart;
+
+	//! per cosolvent the frame since which it is in the shell / a bridge, censored or numFrames if it is not
+	std::vector<uint32_t> shellStart;
+	std::vector<uint32_t> bridgeStart;
+	std::vector<bool> inShell;
+	std::vector<bool> isBridge;
+
+	IntegerHistogram shellResidence;
+	IntegerHistogram bridgeLifetime;
+	IntegerHistogram contactLifetime;
+
+	MultiTauCorrelator shellCorrelator;
+	MultiTauCorrelator bridgeCorrelator;
+
+	//! indicator values of the current frame for the correlators
+	std::vector<double> shellIndicator;
+	std::vector<double> bridgeIndicator;
+
+	uint32_t numFrames;
+	uint64_t firstAge;
+	uint64_t lastAge;
+
+	void evaluateFrame();
+	void diffContacts();
+
+	//! interval that ends at the current frame
+	void addInterval(IntegerHistogram& histogram, uint32_t start) const
+	{
+		if (start != censored)
+			histogram.add(numFrames - start);
+	}
+
+	double getFrameInterval() const { return numFrames > 1 ? double(lastAge - firstAge) / double(numFrames - 1) : 0.0; }
+
+	std::string getOutputName(const std::string& suffix) const;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+template <class IngredientsType>
+AnalyzerCosolventResidenceTime<IngredientsType>::AnalyzerCosolventResidenceTime(const IngredientsType &ing, uint64_t startTime_, std::string dstDir_,
+                                                                                 uint32_t minContourSpan_, uint32_t maxResidenceTime_, uint32_t numCorrelatorLevels_)
+	: ingredients(ing), startTime(startTime_), dstdir(dstDir_), maxResidenceTime(maxResidenceTime_), numCorrelatorLevels(numCorrelatorLevels_),
+	  bridgeEngine(minContourSpan_), numFrames(0), firstAge(0), lastAge(0)
+{
+}
+
+template <class IngredientsType>
+void AnalyzerCosolventResidenceTime<IngredientsType>::initialize()
+{
+	polymerLattice.setup(ingredients);
+	bridgeEngine.build(ingredients.getMolecules());
+
+	if (bridgeEngine.getNumNetworkChains() > 0)
+		std::cout << "AnalyzerCosolventResidenceTime: " << bridgeEngine.getNumNetworkChains()
+				  << " molecules with cycles other than rings, their contour spans are upper bounds along a spanning tree" << std::endl;
+
+	cosolvent.clear();
+	for (size_t n = 0; n < ingredients.getMolecules().size(); n++)
+		if (ingredients.getMolecules()[n].getAttributeTag() == 3)
+			cosolvent.push_back(uint32_t(n));
+
+	shellStart.assign(cosolvent.size(), 0);
+	bridgeStart.assign(cosolvent.size(), 0);
+	inShell.assign(cosolvent.size(), false);
+	isBridge.assign(cosolvent.size(), false);
+	shellIndicator.assign(cosolvent.size(), 0.0);
+	bridgeIndicator.assign(cosolvent.size(), 0.0);
+
+	contactKeys.clear();
+	contactStart.clear();
+
+	shellResidence.reset(maxResidenceTime + 1);
+	bridgeLifetime.reset(maxResidenceTime + 1);
+	contactLifetime.reset(maxResidenceTime + 1);
+
+	shellCorrelator = MultiTauCorrelator(cosolvent.size(), numCorrelatorLevels);
+	bridgeCorrelator = MultiTauCorrelator(cosolvent.size(), numCorrelatorLevels);
+
+	numFrames = 0;
+}
+
+template <class IngredientsType>
+bool AnalyzerCosolventResidenceTime<IngredientsType>::execute()
+{
+	if (ingredients.getMolecules().getAge() >= startTime)
+	{
+		std::cout << "AnalyzerCosolventResidenceTime.execute() at MCS:" << ingredients.getMolecules().getAge() << std::endl;
+
+		evaluateFrame();
+	}
+
+	return true;
+}
+
+/******************************************************************************/
+/**
+ * @fn void AnalyzerCosolventResidenceTime::evaluateFrame()
+ * @brief contacts and bridge state of every cosolvent, ends and starts of the intervals
+ */
+template <class IngredientsType>
+void AnalyzerCosolventResidenceTime<IngredientsType>::evaluateFrame()
+{
+	if (numFrames == 0)
+		firstAge = ingredients.getMolecules().getAge();
+	lastAge = ingredients.getMolecules().getAge();
+
+	polymerLattice.update(ingredients, 1);
+
+	uint32_t contacts[ChainBridgeEngine::MAX_CONTACTS];
+
+	newContactKeys.clear();
+
+	for (size_t c = 0; c < cosolvent.size(); c++)
+	{
+		const VectorInt3 pos = ingredients.getMolecules()[cosolvent[c]];
+		const size_t numContacts = polymerLattice.collectShell(pos, contacts);
+		std::sort(contacts, contacts + numContacts);
+		for (size_t k = 0; k < numContacts; k++)
+			newContactKeys.push_back((uint64_t(c) << 32) | uint64_t(contacts[k]));
+
+		const bool nowInShell = numContacts > 0;
+		const bool nowBridge = numContacts > 1 && bridgeEngine.classify(contacts, numContacts).isBridge();
+
+		if (nowInShell != inShell[c] || numFrames == 0)
+		{
+			if (inShell[c])
+				addInterval(shellResidence, shellStart[c]);
+			shellStart[c] = (numFrames == 0) ? censored : numFrames;
+			inShell[c] = nowInShell;
+		}
+		if (nowBridge != isBridge[c] || numFrames == 0)
+		{
+			if (isBridge[c])
+				addInterval(bridgeLifetime, bridgeStart[c]);
+			bridgeStart[c] = (numFrames == 0) ? censored : numFrames;
+			isBridge[c] = nowBridge;
+		}
+
+		shellIndicator[c] = nowInShell ? 1.0 : 0.0;
+		bridgeIndicator[c] = nowBridge ? 1.0 : 0.0;
+	}
+
+	diffContacts();
+
+	shellCorrelator.add(shellIndicator.data());
+	bridgeCorrelator.add(bridgeIndicator.data());
+
+	numFrames++;
+}
+
+/******************************************************************************/
+/**
+ * @fn void AnalyzerCosolventResidenceTime::diffContacts()
+ * @brief merges the sorted contacts of the last and the current frame in linear time
+ * @details Contacts in both frames keep their start, contacts only in the last
+ * frame have ended and are counted, contacts only in the current frame start now.
+ */
+template <class IngredientsType>
+void AnalyzerCosolventResidenceTime<IngredientsType>::diffContacts()
+{
+	const uint32_t startNow = (numFrames == 0) ? censored : numFrames;
+
+	newContactStart.resize(newContactKeys.size());
+
+	size_t previous = 0;
+	for (size_t k = 0; k < newContactKeys.size(); k++)
+	{
+		while (previous < contactKeys.size() && contactKeys[previous] < newContactKeys[k])
+			addInterval(contactLifetime, contactStart[previous++]);
+
+		if (previous < contactKeys.size() && contactKeys[previous] == newContactKeys[k])
+			newContactStart[k] = contactStart[previous++];
+		else
+			newContactStart[k] = startNow;
+	}
+	while (previous < contactKeys.size())
+		addInterval(contactLifetime, contactStart[previous++]);
+
+	contactKeys.swap(newContactKeys);
+	contactStart.swap(newContactStart);
+}
+
+template <class IngredientsType>
+std::string AnalyzerCosolventResidenceTime<IngredientsType>::getOutputName(const std::string& suffix) const
+{
+	// find the filename without path and extensions
+	std::string filenameGeneral = ingredients.getName();
+	std::string::size_type const slash(filenameGeneral.find_last_of("\\/"));
+	if (slash != std::string::npos)
+		filenameGeneral = filenameGeneral.substr(slash + 1);
+
+	std::string::size_type const p(filenameGeneral.find_last_of('.'));
+	return filenameGeneral.substr(0, p) + suffix;
+}
+
+template <class IngredientsType>
+void AnalyzerCosolventResidenceTime<IngredientsType>::cleanup()
+{
+	std::cout << "File output" << std::endl;
+
+	const double frameInterval = getFrameInterval();
+
+	// intervals that are still open at the last frame
+	uint64_t openShell = 0, openBridges = 0;
+	for (size_t c = 0; c < cosolvent.size(); c++)
+	{
+		if (inShell[c])
+			openShell++;
+		if (isBridge[c])
+			openBridges++;
+	}
+
+	// residence time distributions
+	{
+		std::vector<std::vector<double> > tmpResults(8, std::vector<double>(maxResidenceTime));
+		const IntegerHistogram* histograms[3] = {&shellResidence, &bridgeLifetime, &contactLifetime};
+		for (uint32_t t = 1; t <= maxResidenceTime; t++)
+		{
+			tmpResults[0][t - 1] = t;
+			tmpResults[1][t - 1] = t * frameInterval;
+			for (int h = 0; h < 3; h++)
+			{
+				const uint64_t samples = histograms[h]->getNumSamples();
+				tmpResults[2 + 2 * h][t - 1] = histograms[h]->getCount(t);
+				tmpResults[3 + 2 * h][t - 1] = samples > 0 ? double(histograms[h]->getCount(t)) / double(samples) : 0.0;
+			}
+		}
+
+		std::stringstream comment;
+		comment << "File produced by analyzer AnalyzerCosolventResidenceTime\n"
+				<< "Residence time of cosolvent in the NN-shell of the polymere, lifetime of bridges (min contour span "
+				<< bridgeEngine.getMinContourSpan() << ") and of single contacts (diff*diff <= 6)\n"
+				<< "frames: " << numFrames << " mean frame interval: " << frameInterval << " MCS\n"
+				<< "shell:   intervals " << shellResidence.getNumSamples() << " mean " << shellResidence.getMean()
+				<< " frames, longer than the last bin " << shellResidence.getNumOverflow() << ", still open " << openShell << "\n"
+				<< "bridge:  intervals " << bridgeLifetime.getNumSamples() << " mean " << bridgeLifetime.getMean()
+				<< " frames, longer than the last bin " << bridgeLifetime.getNumOverflow() << ", still open " << openBridges << "\n"
+				<< "contact: intervals " << contactLifetime.getNumSamples() << " mean " << contactLifetime.getMean()
+				<< " frames, longer than the last bin " << contactLifetime.getNumOverflow() << ", still open " << contactKeys.size() << "\n"
+				<< "intervals already open at the first frame are not counted\n"
+				<< "\n"
+				<< "t/frames\tt/MCS\tnShell\tpShell\tnBridge\tpBridge\tnContact\tpContact\n";
+
+		std::string filename = getOutputName("_ResidenceTime.dat");
+		std::cout << " Write output to: " << dstdir << "/" << filename << std::endl;
+		ResultFormattingTools::writeResultFile(dstdir + "/" + filename, this->ingredients, tmpResults, comment.str());
+	}
+
+	// survival autocorrelation
+	{
+		const size_t numLags = std::min(shellCorrelator.getNumLags(), bridgeCorrelator.getNumLags());
+		std::vector<std::vector<double> > tmpResults(7, std::vector<double>(numLags));
+
+		const double shell0 = shellCorrelator.getCorrelation(0);
+		const double bridge0 = bridgeCorrelator.getCorrelation(0);
+
+		for (size_t i = 0; i < numLags; i++)
+		{
+			tmpResults[0][i] = shellCorrelator.getLag(i);
+			tmpResults[1][i] = shellCorrelator.getLag(i) * frameInterval;
+			tmpResults[2][i] = shellCorrelator.getCorrelation(i);
+			tmpResults[3][i] = shell0 > 0.0 ? shellCorrelator.getCorrelation(i) / shell0 : 0.0;
+			tmpResults[4][i] = bridgeCorrelator.getCorrelation(i);
+			tmpResults[5][i] = bridge0 > 0.0 ? bridgeCorrelator.getCorrelation(i) / bridge0 : 0.0;
+			tmpResults[6][i] = shellCorrelator.getNumSamples(i);
+		}
+
+		std::stringstream comment;
+		comment << "File produced by analyzer AnalyzerCosolventResidenceTime\n"
+				<< "Intermittent survival function of cosolvent in the NN-shell (h) and as bridge (b), multiple-tau correlator with "
+				<< numCorrelatorLevels << " levels\n"
+				<< "number of cosolvent: " << cosolvent.size() << " frames: " << numFrames << " mean frame interval: " << frameInterval << " MCS\n"
+				<< "\n"
+				<< "t/frames\tt/MCS\t<h(0)h(t)>\t<h(0)h(t)>/<h>\t<b(0)b(t)>\t<b(0)b(t)>/<b>\tsamples\n";
+
+		std::string filename = getOutputName("_SurvivalCorrelation.dat");
+		std::cout << " Write output to: " << dstdir << "/" << filename << std::endl;
+		ResultFormattingTools::writeResultFile(dstdir + "/" + filename, this->ingredients, tmpResults, comment.str());
+	}
+}
+
+#endif /*AnalyzerCosolventResidenceTime_H*/
@@ -0,0 +1,131 @@
+#include <cstring>
+
+#include <iostream>
+#include <iomanip>
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+#include <LeMonADE/core/ConfigureSystem.h>
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureNNInteractionSc.h>
+#include <LeMonADE/utility/TaskManager.h>
+#include <LeMonADE/updater/UpdaterReadBfmFile.h>
+
+#include "catchorg/clara/clara.hpp"
+
+#include "AnalyzerCosolventResidenceTime.h"
+
+
+
+int main(int argc, char* argv[])
+{
+	try{
+		std::string infile  = "input.bfm";
+
+		uint64_t startAge = 0;
+		uint32_t minContourSpan = 5;
+		uint32_t maxResidenceTime = 1000;
+		uint32_t numCorrelatorLevels = 16;
+
+		bool showHelp = false;
+
+		auto parser
+		= clara::Opt( infile, "input (=input.bfm)" )
+		["-i"]["--infile"]
+			   ("BFM-file to load.")
+			   .required()
+		| clara::Opt( startAge, "start MCS(=0)" )
+		["-s"]["--startAge"]
+			   ("(required) first Monte-Carlo step that is analysed.")
+			   .required()
+		| clara::Opt( [&minContourSpan](int const b)
+					   {
+			if (b < 1)
+			{
+				return clara::ParserResult::runtimeError("Minimum contour span of a bridge must be greater than 0.");
+			}
+			else
+			{
+				minContourSpan = b;
+				return clara::ParserResult::ok(clara::ParseResultType::Matched);
+			}
+					   }, "span(=5)" )
+		["-b"]["--min-span"]
+			   ("minimum number of bonds along the chain between two contacts of an intra-chain bridge.")
+		| clara::Opt( [&maxResidenceTime](int const m)
+					   {
+			if (m < 1)
+			{
+				return clara::ParserResult::runtimeError("Maximum residence time must be greater than 0.");
+			}
+			else
+			{
+				maxResidenceTime = m;
+				return clara::ParserResult::ok(clara::ParseResultType::Matched);
+			}
+					   }, "frames(=1000)" )
+		["-m"]["--max-time"]
+			   ("largest residence time in frames of the distributions, longer intervals are only counted in the header.")
+		| clara::Opt( [&numCorrelatorLevels](int const c)
+					   {
+			if (c < 1)
+			{
+				return clara::ParserResult::runtimeError("Number of correlator levels must be greater than 0.");
+			}
+			else
+			{
+				numCorrelatorLevels = c;
+				return clara::ParserResult::ok(clara::ParseResultType::Matched);
+			}
+					   }, "levels(=16)" )
+		["-c"]["--correlator-levels"]
+			   ("levels of the multiple-tau correlator, the largest lag is 16*2^(levels-1) frames.")
+		 | clara::Help( showHelp );
+
+		auto result = parser.parse( clara::Args( argc, argv ) );
+		if( !result ) {
+			std::cerr << "Error in command line: " << result.errorMessage() << std::endl;
+			exit(1);
+		}
+		else if(showHelp == true)
+		{
+			std::cout << "Residence times of the cosolvent in the NN-shell of the polymer, lifetimes of bridges and contacts" << std::endl
+					<< "and the survival autocorrelation of shell and bridge state" << std::endl;
+
+			parser.writeToStream(std::cout);
+			exit(0);
+		}
+		else
+		{
+			std::cout << "infile:              " << infile << std::endl
+					<< "startAge:            " << startAge << std::endl
+					<< "minContourSpan:      " << minContourSpan << std::endl
+					<< "maxResidenceTime:    " << maxResidenceTime << std::endl
+					<< "numCorrelatorLevels: " << numCorrelatorLevels << std::endl
+					;
+		}
+
+	//seed the globally available random number generators
+	RandomNumberGenerators rng;
+	rng.seedAll();
+
+	typedef LOKI_TYPELIST_3(FeatureMoleculesIO, FeatureAttributes< >, FeatureNNInteractionSc< FeatureLattice >) Features;
+
+	typedef ConfigureSystem<VectorInt3,Features, 2> Config;
+	typedef Ingredients<Config> Ing;
+	Ing myIngredients;
+
+	TaskManager taskmanager;
+	taskmanager.addUpdater(new UpdaterReadBfmFile<Ing>(infile, myIngredients,UpdaterReadBfmFile<Ing>::READ_STEPWISE));
+	taskmanager.addAnalyzer(new AnalyzerCosolventResidenceTime<Ing>(myIngredients, startAge, "./", minContourSpan, maxResidenceTime, numCorrelatorLevels));
+
+	taskmanager.initialize();
+	taskmanager.run();
+	taskmanager.cleanup();
+
+	}
+	catch(std::exception& err){std::cerr<<err.what();}
+	return 0;
+
+}
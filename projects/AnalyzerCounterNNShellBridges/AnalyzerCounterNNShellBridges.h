@@ -28,6 +28,7 @@ along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef AnalyzerCounterNNShellContacts_H
 #define AnalyzerCounterNNShellContacts_H
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <utility> // std::pair
@@ -38,6 +39,10 @@ along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
 #include <LeMonADE/utility/DistanceCalculation.h>
 
 #include "StatisticMoment.h"
+#include "MonomerIndexLattice.h"
+#include "ChainBridgeEngine.h"
+#include "IntegerHistogram.h"
+#include "ParallelTasks.h"
 
 // polymere attribute tag = 1
 // solvent attribute tag = 2
@@ -47,7 +52,9 @@ template <class IngredientsType>
 class AnalyzerCounterNNShellContacts : public AbstractAnalyzer
 {
 public:
-	AnalyzerCounterNNShellContacts(const IngredientsType &ing, uint64_t startTime_, std::string dstDir_);
+	//! minContourSpan: minimum contour distance of two contacts on one chain for an intra-chain bridge
+	//! numThreads: threads sharing the loop over the cosolvent
+	AnalyzerCounterNNShellContacts(const IngredientsType &ing, uint64_t startTime_, std::string dstDir_, uint32_t minContourSpan_ = 5, uint32_t numThreads_ = 1);
 
 	virtual ~AnalyzerCounterNNShellContacts(){
 
@@ -67,13 +74,54 @@ public:
 	void getNumberCoSolventInNNShell();
 
 private:
+	//! cosolvent per work item of the thread loop
+	enum {COSOLVENT_BLOCK = 64};
+
+	//! counts of one thread, only added to once per block, the histograms are merged in cleanup()
+	struct ThreadCounts
+	{
+		int32_t numInShell;
+		int32_t numAsBridge;
+		int32_t numAnyBridge;
+		int32_t numInterChain;
+
+		IntegerHistogram contactsHistogram;
+		IntegerHistogram spanHistogram;
+	};
+
+	void writeHistogram(const std::string& filename, const IntegerHistogram& histogram, const std::string& description) const;
+
 	const IngredientsType &ingredients;
 
 	StatisticMoment Statistic_numCosolventInShell;
 	StatisticMoment Statistic_numCosolventAsBridge;
+	StatisticMoment Statistic_numCosolventAsAnyBridge;
+	StatisticMoment Statistic_numCosolventAsInterChainBridge;
 
 	StatisticMoment Statistic_NumCosolventMonomers;
 
+	//! indices of the polymer monomers (tag 1) on the lattice, refreshed every frame
+	MonomerIndexLattice polymerLattice;
+
+	//! chain and contour position of every monomer, built once in initialize()
+	ChainBridgeEngine bridgeEngine;
+
+	//! number of contacts of every cosolvent in every frame
+	IntegerHistogram contactsHistogram;
+
+	//! largest contour span of the contacts on one chain, for cosolvent with at least two contacts on a chain
+	IntegerHistogram spanHistogram;
+
+	//! indices of the cosolvent (tag 3), fixed in initialize()
+	std::vector<uint32_t> cosolvent;
+
+	uint32_t numThreads;
+
+	//! workers of the cosolvent loop, started in initialize() and reused every frame
+	ParallelTasks::ThreadPool threadPool;
+
+	std::vector<ThreadCounts> threadCounts;
+
 	uint64_t startTime;
 
 	std::string filename;
@@ -85,18 +133,45 @@ private:
 /////////////////////////////////////////////////////////////////////////////
 
 template <class IngredientsType>
-AnalyzerCounterNNShellContacts<IngredientsType>::AnalyzerCounterNNShellContacts(const IngredientsType &ing, uint64_t startTime_, std::string dstDir_)
-	: ingredients(ing), molecules(ing.getMolecules()), startTime(startTime_), dstdir(dstDir_)
+AnalyzerCounterNNShellContacts<IngredientsType>::AnalyzerCounterNNShellContacts(const IngredientsType &ing, uint64_t startTime_, std::string dstDir_, uint32_t minContourSpan_, uint32_t numThreads_)
+	: ingredients(ing), molecules(ing.getMolecules()), bridgeEngine(minContourSpan_), numThreads(std::max(numThreads_, uint32_t(1))), startTime(startTime_), dstdir(dstDir_)
 {
 
 	Statistic_numCosolventInShell.clear();
 	Statistic_numCosolventAsBridge.clear();
+	Statistic_numCosolventAsAnyBridge.clear();
+	Statistic_numCosolventAsInterChainBridge.clear();
 	Statistic_NumCosolventMonomers.clear();
 }
 
 template <class IngredientsType>
 void AnalyzerCounterNNShellContacts<IngredientsType>::initialize()
 {
+	polymerLattice.setup(ingredients);
+	bridgeEngine.build(ingredients.getMolecules());
+
+	contactsHistogram.reset(ChainBridgeEngine::MAX_CONTACTS + 1);
+	spanHistogram.reset(bridgeEngine.getMaxContourSpan() + 1);
+
+	if (bridgeEngine.getNumNetworkChains() > 0)
+		std::cout << "AnalyzerCounterNNShellBridges: " << bridgeEngine.getNumNetworkChains()
+				  << " molecules with cycles other than rings, their contour spans are upper bounds along a spanning tree" << std::endl;
+
+	cosolvent.clear();
+	for (size_t n = 0; n < ingredients.getMolecules().size(); n++)
+		if (ingredients.getMolecules()[n].getAttributeTag() == 3)
+			cosolvent.push_back(uint32_t(n));
+
+	// at most one thread per block of cosolvent
+	const size_t numBlocks = (cosolvent.size() + COSOLVENT_BLOCK - 1) / COSOLVENT_BLOCK;
+	threadPool.resize(uint32_t(std::max<size_t>(std::min<size_t>(numThreads, numBlocks), 1)));
+
+	threadCounts.resize(threadPool.size());
+	for (size_t t = 0; t < threadCounts.size(); t++)
+	{
+		threadCounts[t].contactsHistogram.reset(contactsHistogram.getNumBins());
+		threadCounts[t].spanHistogram.reset(spanHistogram.getNumBins());
+	}
 
 	//execute();
 }
@@ -114,6 +189,8 @@ bool AnalyzerCounterNNShellContacts<IngredientsType>::execute()
 
 		
 
+		polymerLattice.update(ingredients, 1);
+
 		getNumberCoSolventInNNShell();
 
 		
@@ -126,79 +203,93 @@ template <class IngredientsType>
 void AnalyzerCounterNNShellContacts<IngredientsType>::getNumberCoSolventInNNShell() 
 {
 
-	int32_t numberOfCosolventInShell = 0;
-	int32_t numberOfCosolventAsBridges = 0;
-
-	int32_t minPolymereForBridge = 5; // minimum number of polymere to be between two contacts in order to count as bridge
-
-
-
-	//loop through all polymer
-	for (size_t n = 0; n < ingredients.getMolecules().size(); n++)
+	for (size_t t = 0; t < threadCounts.size(); t++)
 	{
-		
-		int32_t monoType = ingredients.getMolecules()[n].getAttributeTag();
-
-		VectorInt3 posOfCosolvent = ingredients.getMolecules()[n];
-
-		// only for cosolvent
-		if (monoType == 3)
-		{
-			int32_t counterContacts = 0;
-
+		threadCounts[t].numInShell = 0;
+		threadCounts[t].numAsBridge = 0;
+		threadCounts[t].numAnyBridge = 0;
+		threadCounts[t].numInterChain = 0;
+	}
 
-			std::vector<int32_t> IndexOfContactedMonomer; // holds the Index of the contacted polymere monomers per cosolvent
+	// the cosolvent are independent, blocks of them are handed out to the threads
+	const size_t numBlocks = (cosolvent.size() + COSOLVENT_BLOCK - 1) / COSOLVENT_BLOCK;
 
-			for (size_t m = 0; m < ingredients.getMolecules().size(); m++)
-			{
-				int32_t monoType = ingredients.getMolecules()[m].getAttributeTag();
+	threadPool.parallelFor(numBlocks, [&](size_t block, uint32_t threadId){
+		// counted on the stack, the entries of the threads share cache lines
+		int32_t numInShell = 0;
+		int32_t numAsBridge = 0;
+		int32_t numAnyBridge = 0;
+		int32_t numInterChain = 0;
 
-				// only for polymerechain
-				if (monoType == 1)
-				{
-					VectorInt3 posOfChain = ingredients.getMolecules()[m];
-					VectorInt3 diff = LemonadeDistCalcs::MinImageVector(posOfChain, posOfCosolvent, ingredients);
+		// histogram values of the block
+		uint32_t contactsOfBlock[COSOLVENT_BLOCK];
+		uint32_t spansOfBlock[COSOLVENT_BLOCK];
+		size_t numSpans = 0;
 
-					if (diff * diff <= 6)
-					{
-						counterContacts++;
+		uint32_t IndexOfContactedMonomer[ChainBridgeEngine::MAX_CONTACTS]; // holds the Index of the contacted polymere monomers per cosolvent
 
-						IndexOfContactedMonomer.push_back(m);
+		const size_t first = block * COSOLVENT_BLOCK;
+		const size_t end = std::min(cosolvent.size(), first + COSOLVENT_BLOCK);
+		for (size_t c = first; c < end; c++)
+		{
+			VectorInt3 posOfCosolvent = ingredients.getMolecules()[cosolvent[c]];
 
-						
-					}
+			// polymer monomers with a minimum image distance diff * diff <= 6
+			size_t counterContacts = polymerLattice.collectShell(posOfCosolvent, IndexOfContactedMonomer);
 
-					
+			contactsOfBlock[c - first] = uint32_t(counterContacts);
 
-				}
-			}
 			// add one to statistic if at least one interaction is detected
 			if (counterContacts > 0)
 			{
-				numberOfCosolventInShell++;
+				numInShell++;
 			}
-			// add one to bridge statistic if more than one interaction is detected
+			// add one to bridge statistic if the contacts span enough contour of one chain or touch several chains
 			if (counterContacts > 1)
-			{	
-				// sort IndexOfContactedMonomer vector
-				sort(IndexOfContactedMonomer.begin(), IndexOfContactedMonomer.end());
-				
-
-				// check if bridge condition holds
-				if (IndexOfContactedMonomer.back() - IndexOfContactedMonomer.front() >= minPolymereForBridge){
-
-					numberOfCosolventAsBridges++;
-				}
-				
+			{
+				ChainBridgeEngine::Bridge bridge = bridgeEngine.classify(IndexOfContactedMonomer, counterContacts);
+
+				if (bridge.isIntraChain)
+					numAsBridge++;
+				if (bridge.isInterChain)
+					numInterChain++;
+				if (bridge.isBridge())
+					numAnyBridge++;
+
+				// at least one chain with two contacts
+				if (bridge.numContacts > bridge.numChains)
+					spansOfBlock[numSpans++] = bridge.maxContourSpan;
 			}
+		}
 
+		ThreadCounts& counts = threadCounts[threadId];
+		counts.numInShell += numInShell;
+		counts.numAsBridge += numAsBridge;
+		counts.numAnyBridge += numAnyBridge;
+		counts.numInterChain += numInterChain;
+		for (size_t c = 0; c < end - first; c++)
+			counts.contactsHistogram.add(contactsOfBlock[c]);
+		for (size_t s = 0; s < numSpans; s++)
+			counts.spanHistogram.add(spansOfBlock[s]);
+	});
 
+	int32_t numberOfCosolventInShell = 0;
+	int32_t numberOfCosolventAsBridges = 0;
+	int32_t numberOfAnyBridges = 0;
+	int32_t numberOfInterChainBridges = 0;
 
-		}
-
+	for (size_t t = 0; t < threadCounts.size(); t++)
+	{
+		numberOfCosolventInShell += threadCounts[t].numInShell;
+		numberOfCosolventAsBridges += threadCounts[t].numAsBridge;
+		numberOfAnyBridges += threadCounts[t].numAnyBridge;
+		numberOfInterChainBridges += threadCounts[t].numInterChain;
 	}
+
 	Statistic_numCosolventInShell.AddValue(numberOfCosolventInShell);
 	Statistic_numCosolventAsBridge.AddValue(numberOfCosolventAsBridges);
+	Statistic_numCosolventAsAnyBridge.AddValue(numberOfAnyBridges);
+	Statistic_numCosolventAsInterChainBridge.AddValue(numberOfInterChainBridges);
 
 
 	return;
@@ -230,13 +321,21 @@ void AnalyzerCounterNNShellContacts<IngredientsType>::cleanup()
 	}
 
 	std::cout << "File output" << std::endl;
+
+	for (size_t t = 0; t < threadCounts.size(); t++)
+	{
+		contactsHistogram.merge(threadCounts[t].contactsHistogram);
+		spanHistogram.merge(threadCounts[t].spanHistogram);
+		threadCounts[t].contactsHistogram.clear();
+		threadCounts[t].spanHistogram.clear();
+	}
 	
 
 	std::vector<std::vector<double>> tmpResults;
 
-	tmpResults.resize(5);
+	tmpResults.resize(9);
 
-	for (int i = 0; i < 5; i++)
+	for (int i = 0; i < 9; i++)
 		tmpResults[i].resize(1);
 
 	tmpResults[0][0] = counterCosolvent;
@@ -244,14 +343,22 @@ void AnalyzerCounterNNShellContacts<IngredientsType>::cleanup()
 	tmpResults[2][0] = Statistic_numCosolventInShell.ReturnM2();
 	tmpResults[3][0] = Statistic_numCosolventAsBridge.ReturnM1() ;
 	tmpResults[4][0] = Statistic_numCosolventAsBridge.ReturnM2();
+	tmpResults[5][0] = Statistic_numCosolventAsInterChainBridge.ReturnM1();
+	tmpResults[6][0] = Statistic_numCosolventAsInterChainBridge.ReturnM2();
+	tmpResults[7][0] = Statistic_numCosolventAsAnyBridge.ReturnM1();
+	tmpResults[8][0] = Statistic_numCosolventAsAnyBridge.ReturnM2();
 
 	std::stringstream comment;
 	comment << "File produced by analyzer AnalyzerCounterNNShellContacts\n"
 			<< "Analyze CoSolventPolyereBridges\n"
 			<< "eta: Number of Cosolvent in NNShell in vicinity of polymere\n"
-			<< "gamma: Number of Bridge building Cosolvent with Polymere\n"
-			<< "\n"
-			<< "numCoSolvent\t<eta>\t<eta²>\t<gamma>\t<gamma^2>\n";
+			<< "gamma: Number of Bridge building Cosolvent with Polymere, contacts on one chain at least " << bridgeEngine.getMinContourSpan() << " bonds apart along the shortest bond path\n"
+			<< "gamma_inter: contacts on at least two chains\n"
+			<< "gamma_any: gamma or gamma_inter\n";
+	if (bridgeEngine.getNumNetworkChains() > 0)
+		comment << "spans on the " << bridgeEngine.getNumNetworkChains() << " molecules with cycles other than rings are upper bounds along a spanning tree\n";
+	comment << "\n"
+			<< "numCoSolvent\t<eta>\t<eta²>\t<gamma>\t<gamma^2>\t<gamma_inter>\t<gamma_inter^2>\t<gamma_any>\t<gamma_any^2>\n";
 
 	// find the filename without path and extensions
 	std::string filenameGeneral = std::string(std::find_if(ingredients.getName().rbegin(), ingredients.getName().rend(), PathSeparator()).base(), ingredients.getName().end());
@@ -264,6 +371,27 @@ void AnalyzerCounterNNShellContacts<IngredientsType>::cleanup()
 	std::cout << " Write output to: " << dstdir << "/" << filenameRg2_Ree_b2 << std::endl;
 
 	ResultFormattingTools::writeResultFile(dstdir + "/" + filenameRg2_Ree_b2, this->ingredients, tmpResults, comment.str());
+
+	writeHistogram(filenameGeneral + "_AnalyzerCounterNNShellBridges_contacts.dat", contactsHistogram,
+				   "number of polymere contacts (diff*diff <= 6) per cosolvent and frame");
+	writeHistogram(filenameGeneral + "_AnalyzerCounterNNShellBridges_spans.dat", spanHistogram,
+				   "largest contour span of the contacts on one chain, cosolvent with at least two contacts on a chain");
+}
+
+template <class IngredientsType>
+void AnalyzerCounterNNShellContacts<IngredientsType>::writeHistogram(const std::string& filename, const IntegerHistogram& histogram, const std::string& description) const
+{
+	std::stringstream comment;
+	comment << "File produced by analyzer AnalyzerCounterNNShellContacts\n"
+			<< "Histogram of the " << description << "\n"
+			<< "samples: " << histogram.getNumSamples() << " mean: " << histogram.getMean()
+			<< " beyond the last bin: " << histogram.getNumOverflow() << "\n"
+			<< "\n"
+			<< "value\tcount\tfraction\n";
+
+	std::cout << " Write output to: " << dstdir << "/" << filename << std::endl;
+
+	ResultFormattingTools::writeResultFile(dstdir + "/" + filename, this->ingredients, histogram.getColumns(), comment.str());
 }
 
 #endif /*AnalyzerCounterNNShellContacts_H*/
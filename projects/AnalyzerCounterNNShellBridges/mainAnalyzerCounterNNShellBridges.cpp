@@ -30,6 +30,10 @@ int main(int argc, char* argv[])
 		std::string outfile = "outfile.bfm";
 		
 		uint32_t startAge = 0;
+
+		uint32_t minContourSpan = 5;
+
+		uint32_t numThreads = ParallelTasks::getDefaultNumThreads();
 		
 
 		
@@ -59,8 +63,34 @@ int main(int argc, char* argv[])
 		["-s"]["--startAge"]
 			   ("(required) specifies the total Monte-Carlo steps to simulate.")
 			   .required()
-			   
-		
+		| clara::Opt( [&minContourSpan](int const b)
+					   {
+			if (b < 1)
+			{
+				return clara::ParserResult::runtimeError("Minimum contour span of a bridge must be greater than 0.");
+			}
+			else
+			{
+				minContourSpan = b;
+				return clara::ParserResult::ok(clara::ParseResultType::Matched);
+			}
+					   }, "span(=5)" )
+		["-b"]["--min-span"]
+			   ("minimum number of bonds along the chain between two contacts of an intra-chain bridge.")
+		| clara::Opt( [&numThreads](int const t)
+					   {
+			if (t < 1)
+			{
+				return clara::ParserResult::runtimeError("Number of threads must be greater than 0.");
+			}
+			else
+			{
+				numThreads = t;
+				return clara::ParserResult::ok(clara::ParseResultType::Matched);
+			}
+					   }, "threads(=hardware threads)" )
+		["-t"]["--threads"]
+			   ("number of threads sharing the loop over the cosolvent, at most one per 64 cosolvent.")
 		 | clara::Help( showHelp );
 
 		auto result = parser.parse( clara::Args( argc, argv ) );
@@ -81,6 +111,8 @@ int main(int argc, char* argv[])
 			std::cout << "infile:        " << infile << std::endl
 					<< "outfile:       " << outfile << std::endl
 					<< "startAge:       " << startAge << std::endl
+					<< "minContourSpan: " << minContourSpan << std::endl
+					<< "numThreads:     " << numThreads << std::endl
 					
 
 					;
@@ -106,7 +138,7 @@ int main(int argc, char* argv[])
 	//(other than for latticeOccupation, valid bonds, frozen monomers...)
 	//taskmanager.addUpdater(new UpdaterSimpleSimulator<Ing,MoveLocalSc>(myIngredients,save_interval));
     
-    taskmanager.addAnalyzer(new AnalyzerCounterNNShellContacts<Ing>(myIngredients, startAge,  "./"));
+    taskmanager.addAnalyzer(new AnalyzerCounterNNShellContacts<Ing>(myIngredients, startAge,  "./", minContourSpan, numThreads));
 
 	//taskmanager.addAnalyzer(new AnalyzerWriteBfmFile<Ing>(outfile,myIngredients));
 	
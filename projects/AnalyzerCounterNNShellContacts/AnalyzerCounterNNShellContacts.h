@@ -28,6 +28,7 @@ along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef AnalyzerCounterNNShellContacts_H
 #define AnalyzerCounterNNShellContacts_H
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <utility> // std::pair
@@ -38,6 +39,8 @@ along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
 #include <LeMonADE/utility/DistanceCalculation.h>
 
 #include "StatisticMoment.h"
+#include "MonomerIndexLattice.h"
+#include "ParallelTasks.h"
 
 // polymere attribute tag = 1
 // solvent attribute tag = 2
@@ -47,7 +50,8 @@ template <class IngredientsType>
 class AnalyzerCounterNNShellContacts : public AbstractAnalyzer
 {
 public:
-	AnalyzerCounterNNShellContacts(const IngredientsType &ing, uint64_t startTime_, std::string dstDir_);
+	//! numThreads: threads sharing the loop over the cosolvent
+	AnalyzerCounterNNShellContacts(const IngredientsType &ing, uint64_t startTime_, std::string dstDir_, uint32_t numThreads_ = 1);
 
 	virtual ~AnalyzerCounterNNShellContacts(){
 
@@ -67,6 +71,16 @@ public:
 	void getNumberCoSolventInNNShell();
 
 private:
+	//! cosolvent per work item of the thread loop
+	enum {COSOLVENT_BLOCK = 64};
+
+	//! counts of one thread in the current frame, only added to once per block
+	struct ThreadCounts
+	{
+		int32_t numInShell;
+		int32_t numAsBridge;
+	};
+
 	const IngredientsType &ingredients;
 
 	StatisticMoment Statistic_numCosolventInShell;
@@ -74,6 +88,19 @@ private:
 
 	StatisticMoment Statistic_NumCosolventMonomers;
 
+	//! indices of the polymer monomers (tag 1) on the lattice, refreshed every frame
+	MonomerIndexLattice polymerLattice;
+
+	//! indices of the cosolvent (tag 3), fixed in initialize()
+	std::vector<uint32_t> cosolvent;
+
+	uint32_t numThreads;
+
+	//! workers of the cosolvent loop, started in initialize() and reused every frame
+	ParallelTasks::ThreadPool threadPool;
+
+	std::vector<ThreadCounts> threadCounts;
+
 	uint64_t startTime;
 
 	std::string filename;
@@ -85,8 +112,8 @@ private:
 /////////////////////////////////////////////////////////////////////////////
 
 template <class IngredientsType>
-AnalyzerCounterNNShellContacts<IngredientsType>::AnalyzerCounterNNShellContacts(const IngredientsType &ing, uint64_t startTime_, std::string dstDir_)
-	: ingredients(ing), molecules(ing.getMolecules()), startTime(startTime_), dstdir(dstDir_)
+AnalyzerCounterNNShellContacts<IngredientsType>::AnalyzerCounterNNShellContacts(const IngredientsType &ing, uint64_t startTime_, std::string dstDir_, uint32_t numThreads_)
+	: ingredients(ing), molecules(ing.getMolecules()), numThreads(std::max(numThreads_, uint32_t(1))), startTime(startTime_), dstdir(dstDir_)
 {
 
 	Statistic_numCosolventInShell.clear();
@@ -97,6 +124,18 @@ AnalyzerCounterNNShellContacts<IngredientsType>::AnalyzerCounterNNShellContacts(
 template <class IngredientsType>
 void AnalyzerCounterNNShellContacts<IngredientsType>::initialize()
 {
+	polymerLattice.setup(ingredients);
+
+	cosolvent.clear();
+	for (size_t n = 0; n < ingredients.getMolecules().size(); n++)
+		if (ingredients.getMolecules()[n].getAttributeTag() == 3)
+			cosolvent.push_back(uint32_t(n));
+
+	// at most one thread per block of cosolvent
+	const size_t numBlocks = (cosolvent.size() + COSOLVENT_BLOCK - 1) / COSOLVENT_BLOCK;
+	threadPool.resize(uint32_t(std::max<size_t>(std::min<size_t>(numThreads, numBlocks), 1)));
+
+	threadCounts.resize(threadPool.size());
 
 	//execute();
 }
@@ -114,6 +153,8 @@ bool AnalyzerCounterNNShellContacts<IngredientsType>::execute()
 
 		
 
+		polymerLattice.update(ingredients, 1);
+
 		getNumberCoSolventInNNShell();
 
 		
@@ -126,61 +167,52 @@ template <class IngredientsType>
 void AnalyzerCounterNNShellContacts<IngredientsType>::getNumberCoSolventInNNShell() 
 {
 
-	int32_t numberOfCosolventInShell = 0;
-	int32_t numberOfCosolventAsBridges = 0;
-
-	int32_t numberOfLastFoundContact = 0;
-
-	//loop through all polymer
-	for (size_t n = 0; n < ingredients.getMolecules().size(); n++)
+	for (size_t t = 0; t < threadCounts.size(); t++)
 	{
-		
-		int32_t monoType = ingredients.getMolecules()[n].getAttributeTag();
+		threadCounts[t].numInShell = 0;
+		threadCounts[t].numAsBridge = 0;
+	}
 
-		VectorInt3 posOfCosolvent = ingredients.getMolecules()[n];
+	// the cosolvent are independent, blocks of them are handed out to the threads
+	const size_t numBlocks = (cosolvent.size() + COSOLVENT_BLOCK - 1) / COSOLVENT_BLOCK;
+	threadPool.parallelFor(numBlocks, [&](size_t block, uint32_t threadId){
+		// counted on the stack, the entries of the threads share cache lines
+		int32_t numInShell = 0;
+		int32_t numAsBridge = 0;
 
-		// only for cosolvent
-		if (monoType == 3)
+		const size_t end = std::min(cosolvent.size(), (block + 1) * COSOLVENT_BLOCK);
+		for (size_t c = block * COSOLVENT_BLOCK; c < end; c++)
 		{
-			int32_t counterContacts = 0;
-
-			for (size_t m = 0; m < ingredients.getMolecules().size(); m++)
-			{
-				int32_t monoType = ingredients.getMolecules()[m].getAttributeTag();
-
-				// only for polymerechain
-				if (monoType == 1)
-				{
-					VectorInt3 posOfChain = ingredients.getMolecules()[m];
-					VectorInt3 diff = LemonadeDistCalcs::MinImageVector(posOfChain, posOfCosolvent, ingredients);
-
-					if (diff * diff <= 6)
-					{
-						counterContacts++;
+			VectorInt3 posOfCosolvent = ingredients.getMolecules()[cosolvent[c]];
 
-						
-					}
+			// polymer monomers with a minimum image distance diff * diff <= 6
+			int32_t counterContacts = int32_t(polymerLattice.countShell(posOfCosolvent));
 
-					// save number of last found contact
-
-				}
-			}
 			// add one to statistic if at least one interaction is detected
 			if (counterContacts > 0)
 			{
-				numberOfCosolventInShell++;
+				numInShell++;
 			}
 			// add one to bridge statistic if more than one interaction is detected
 			if (counterContacts > 1)
 			{
-				numberOfCosolventAsBridges++;
+				numAsBridge++;
 			}
+		}
 
+		threadCounts[threadId].numInShell += numInShell;
+		threadCounts[threadId].numAsBridge += numAsBridge;
+	});
 
+	int32_t numberOfCosolventInShell = 0;
+	int32_t numberOfCosolventAsBridges = 0;
 
-		}
-
+	for (size_t t = 0; t < threadCounts.size(); t++)
+	{
+		numberOfCosolventInShell += threadCounts[t].numInShell;
+		numberOfCosolventAsBridges += threadCounts[t].numAsBridge;
 	}
+
 	Statistic_numCosolventInShell.AddValue(numberOfCosolventInShell);
 	Statistic_numCosolventAsBridge.AddValue(numberOfCosolventAsBridges);
 
@@ -30,6 +30,8 @@ int main(int argc, char* argv[])
 		std::string outfile = "outfile.bfm";
 		
 		uint32_t startAge = 0;
+
+		uint32_t numThreads = ParallelTasks::getDefaultNumThreads();
 		
 
 		
@@ -59,8 +61,20 @@ int main(int argc, char* argv[])
 		["-s"]["--startAge"]
 			   ("(required) specifies the total Monte-Carlo steps to simulate.")
 			   .required()
-			   
-		
+		| clara::Opt( [&numThreads](int const t)
+					   {
+			if (t < 1)
+			{
+				return clara::ParserResult::runtimeError("Number of threads must be greater than 0.");
+			}
+			else
+			{
+				numThreads = t;
+				return clara::ParserResult::ok(clara::ParseResultType::Matched);
+			}
+					   }, "threads(=hardware threads)" )
+		["-t"]["--threads"]
+			   ("number of threads sharing the loop over the cosolvent, at most one per 64 cosolvent.")
 		 | clara::Help( showHelp );
 
 		auto result = parser.parse( clara::Args( argc, argv ) );
@@ -81,6 +95,7 @@ int main(int argc, char* argv[])
 			std::cout << "infile:        " << infile << std::endl
 					<< "outfile:       " << outfile << std::endl
 					<< "startAge:       " << startAge << std::endl
+					<< "numThreads:     " << numThreads << std::endl
 					
 
 					;
@@ -106,7 +121,7 @@ int main(int argc, char* argv[])
 	//(other than for latticeOccupation, valid bonds, frozen monomers...)
 	//taskmanager.addUpdater(new UpdaterSimpleSimulator<Ing,MoveLocalSc>(myIngredients,save_interval));
     
-    taskmanager.addAnalyzer(new AnalyzerCounterNNShellContacts<Ing>(myIngredients, startAge,  "./"));
+    taskmanager.addAnalyzer(new AnalyzerCounterNNShellContacts<Ing>(myIngredients, startAge,  "./", numThreads));
 
 	//taskmanager.addAnalyzer(new AnalyzerWriteBfmFile<Ing>(outfile,myIngredients));
 	
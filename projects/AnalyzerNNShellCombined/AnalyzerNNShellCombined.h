@@ -0,0 +1,255 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2018,2021 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers (Ron Dockhorn)
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef AnalyzerNNShellCombined_H
+#define AnalyzerNNShellCombined_H
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "MonomerIndexLattice.h"
+#include "ChainBridgeEngine.h"
+#include "NNShellObservers.h"
+
+// polymere attribute tag = 1
+// solvent attribute tag = 2
+// cosolvemt attribute tag = 3
+
+/*****************************************************************************/
+/**
+ * @class AnalyzerNNShellCombined
+ * @brief one neighbour pass per frame for the contact, bridge and adsorption observers
+ * @details Every monomer is visited once: its 24 NN-shell sites are read from
+ * the typed lattice (occupancy, vacant sites and NN energies) and, for
+ * cosolvent, the polymer monomers with diff*diff <= 6 are taken from a lattice
+ * of monomer indices. The samples are passed to all observers, which replace
+ * AnalyzerCounterNNShellContacts, AnalyzerCounterNNShellBridges and
+ * AnalyzerAdsorptionIsotherm and write the same files. The shell sites are only
+ * read if an observer needs the samples of all monomers.
+ * */
+/*****************************************************************************/
+template <class IngredientsType>
+class AnalyzerNNShellCombined : public AbstractAnalyzer
+{
+public:
+	//! minContourSpan: minimum contour distance of two contacts on one chain for an intra-chain bridge
+	AnalyzerNNShellCombined(const IngredientsType &ing, uint64_t startTime_, std::string dstDir_, uint32_t minContourSpan_ = 5);
+
+	virtual ~AnalyzerNNShellCombined(){
+
+	};
+
+	//! the analyzer takes ownership of the observer
+	void addObserver(NNShellObserver<IngredientsType>* observer);
+
+	const IngredientsType &getIngredients() const { return ingredients; }
+
+	virtual void initialize();
+	virtual bool execute();
+	virtual void cleanup();
+
+	//! the 24 lattice sites of the NN-shell relative to the position of a monomer
+	static const std::vector<VectorInt3>& getContactSites();
+
+private:
+	const IngredientsType &ingredients;
+
+	uint64_t startTime;
+
+	std::string dstdir;
+
+	//! chain and contour position of every monomer, built once in initialize()
+	ChainBridgeEngine bridgeEngine;
+
+	std::vector< std::unique_ptr< NNShellObserver<IngredientsType> > > observers;
+
+	//! indices of the polymer monomers (tag 1) on the lattice, refreshed every frame
+	MonomerIndexLattice polymerLattice;
+
+	//! reused for every monomer
+	NNShellSample sample;
+
+	void evaluateFrame();
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+template <class IngredientsType>
+AnalyzerNNShellCombined<IngredientsType>::AnalyzerNNShellCombined(const IngredientsType &ing, uint64_t startTime_, std::string dstDir_, uint32_t minContourSpan_)
+	: ingredients(ing), startTime(startTime_), dstdir(dstDir_), bridgeEngine(minContourSpan_)
+{
+}
+
+template <class IngredientsType>
+void AnalyzerNNShellCombined<IngredientsType>::addObserver(NNShellObserver<IngredientsType>* observer)
+{
+	observers.push_back(std::unique_ptr< NNShellObserver<IngredientsType> >(observer));
+}
+
+template <class IngredientsType>
+const std::vector<VectorInt3>& AnalyzerNNShellCombined<IngredientsType>::getContactSites()
+{
+	struct Sites {
+		std::vector<VectorInt3> sites;
+		Sites()
+		{
+			sites.push_back(VectorInt3(2,0,0));
+			sites.push_back(VectorInt3(2,1,0));
+			sites.push_back(VectorInt3(2,0,1));
+			sites.push_back(VectorInt3(2,1,1));
+			sites.push_back(VectorInt3(0,2,0));
+			sites.push_back(VectorInt3(1,2,0));
+			sites.push_back(VectorInt3(0,2,1));
+			sites.push_back(VectorInt3(1,2,1));
+			sites.push_back(VectorInt3(0,0,2));
+			sites.push_back(VectorInt3(1,0,2));
+			sites.push_back(VectorInt3(0,1,2));
+			sites.push_back(VectorInt3(1,1,2));
+
+			sites.push_back(VectorInt3(-1,0,0));
+			sites.push_back(VectorInt3(-1,1,0));
+			sites.push_back(VectorInt3(-1,0,1));
+			sites.push_back(VectorInt3(-1,1,1));
+			sites.push_back(VectorInt3(0,-1,0));
+			sites.push_back(VectorInt3(1,-1,0));
+			sites.push_back(VectorInt3(0,-1,1));
+			sites.push_back(VectorInt3(1,-1,1));
+			sites.push_back(VectorInt3(0,0,-1));
+			sites.push_back(VectorInt3(1,0,-1));
+			sites.push_back(VectorInt3(0,1,-1));
+			sites.push_back(VectorInt3(1,1,-1));
+		}
+	};
+	static const Sites contactSites;
+	return contactSites.sites;
+}
+
+template <class IngredientsType>
+void AnalyzerNNShellCombined<IngredientsType>::initialize()
+{
+	polymerLattice.setup(ingredients);
+	bridgeEngine.build(ingredients.getMolecules());
+
+	if (bridgeEngine.getNumNetworkChains() > 0)
+		std::cout << "AnalyzerNNShellCombined: " << bridgeEngine.getNumNetworkChains()
+				  << " molecules with cycles other than rings, their contour spans are upper bounds along a spanning tree" << std::endl;
+
+	for (size_t o = 0; o < observers.size(); o++)
+		observers[o]->initialize(ingredients, bridgeEngine);
+}
+
+template <class IngredientsType>
+bool AnalyzerNNShellCombined<IngredientsType>::execute()
+{
+	if (ingredients.getMolecules().getAge() >= startTime)
+	{
+		std::cout << "AnalyzerNNShellCombined.execute() at MCS:" << ingredients.getMolecules().getAge() << std::endl;
+
+		evaluateFrame();
+	}
+
+	return true;
+}
+
+/******************************************************************************/
+/**
+ * @fn void AnalyzerNNShellCombined::evaluateFrame()
+ * @brief the neighbour pass over all monomers, feeding the samples to the observers
+ */
+template <class IngredientsType>
+void AnalyzerNNShellCombined<IngredientsType>::evaluateFrame()
+{
+	polymerLattice.update(ingredients, 1);
+
+	bool readShell = false;
+	for (size_t o = 0; o < observers.size(); o++)
+	{
+		readShell = readShell || observers[o]->observesAllMonomers();
+		observers[o]->beginFrame(ingredients);
+	}
+
+	const std::vector<VectorInt3>& contactSites(getContactSites());
+
+	for (size_t n = 0; n < ingredients.getMolecules().size(); n++)
+	{
+		const int32_t monoType = ingredients.getMolecules()[n].getAttributeTag();
+
+		if (!readShell && monoType != 3)
+			continue;
+
+		const VectorInt3 pos = ingredients.getMolecules()[n];
+
+		sample.index = uint32_t(n);
+		sample.tag = monoType;
+		sample.numVacantSites = 0;
+		sample.numContacts = 0;
+		sample.bridge = ChainBridgeEngine::Bridge();
+
+		if (readShell)
+		{
+			for (size_t contactNo = 0; contactNo < contactSites.size(); contactNo++)
+			{
+				const int32_t latticeEntry = int32_t(ingredients.getLatticeEntry(pos + contactSites[contactNo]));
+
+				sample.shellTags[contactNo] = latticeEntry;
+				sample.shellEnergies[contactNo] = (latticeEntry != 0) ? ingredients.getNNInteraction(monoType, latticeEntry) : 0.0;
+				if (latticeEntry != monoType)
+					sample.numVacantSites++;
+			}
+		}
+
+		// only for cosolvent
+		if (monoType == 3)
+		{
+			// polymer monomers with a minimum image distance diff * diff <= 6
+			sample.numContacts = uint32_t(polymerLattice.collectShell(pos, sample.contacts));
+			sample.bridge = bridgeEngine.classify(sample.contacts, sample.numContacts);
+		}
+
+		for (size_t o = 0; o < observers.size(); o++)
+			if (monoType == 3 || observers[o]->observesAllMonomers())
+				observers[o]->addMonomer(ingredients, sample);
+	}
+
+	for (size_t o = 0; o < observers.size(); o++)
+		observers[o]->endFrame(ingredients);
+}
+
+template <class IngredientsType>
+void AnalyzerNNShellCombined<IngredientsType>::cleanup()
+{
+	std::cout << "File output" << std::endl;
+
+	for (size_t o = 0; o < observers.size(); o++)
+		observers[o]->cleanup(ingredients, dstdir);
+}
+
+#endif /*AnalyzerNNShellCombined_H*/
@@ -0,0 +1,437 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2018,2021 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers (Ron Dockhorn)
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef NNShellObservers_H
+#define NNShellObservers_H
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "StatisticMoment.h"
+#include "ChainBridgeEngine.h"
+#include "IntegerHistogram.h"
+
+// polymere attribute tag = 1
+// solvent attribute tag = 2
+// cosolvemt attribute tag = 3
+
+/*****************************************************************************/
+/**
+ * @struct NNShellSample
+ * @brief result of the neighbour pass for one monomer
+ * @details The shell are the 24 lattice sites of the NN-interaction around the
+ * cube of the monomer (see AnalyzerNNShellCombined::getContactSites()). The
+ * contacts are only filled for cosolvent monomers.
+ * */
+/*****************************************************************************/
+struct NNShellSample
+{
+	enum {NUM_SHELL_SITES=24};
+
+	uint32_t index;
+	int32_t tag;
+
+	//! typed lattice entries of the shell sites, 0 for empty sites
+	int32_t shellTags[NUM_SHELL_SITES];
+
+	//! NN interaction of the monomer with every shell site, 0 for empty sites
+	double shellEnergies[NUM_SHELL_SITES];
+
+	//! shell sites that are not occupied by the own species (empty or other species)
+	uint32_t numVacantSites;
+
+	//! indices of the polymer monomers with minimum image distance diff*diff <= 6
+	uint32_t contacts[ChainBridgeEngine::MAX_CONTACTS];
+	uint32_t numContacts;
+
+	//! chains and contour span of the contacts, see ChainBridgeEngine
+	ChainBridgeEngine::Bridge bridge;
+};
+
+/*****************************************************************************/
+/**
+ * @class NNShellObserver
+ * @brief receives the samples of the neighbour pass and writes its own result file
+ * @details initialize() is called once with the chain table of the analyzer.
+ * For every analysed frame beginFrame() is called, then addMonomer()
+ * for every cosolvent monomer (or every monomer if observesAllMonomers()) in
+ * the order of the monomer indices, then endFrame().
+ * */
+/*****************************************************************************/
+template<class IngredientsType>
+class NNShellObserver
+{
+public:
+	virtual ~NNShellObserver(){}
+
+	//! if false only the samples of cosolvent monomers are passed to addMonomer()
+	virtual bool observesAllMonomers() const {return false;}
+
+	virtual void initialize(const IngredientsType& ing, const ChainBridgeEngine& bridgeEngine){}
+	virtual void beginFrame(const IngredientsType& ing){}
+	virtual void addMonomer(const IngredientsType& ing, const NNShellSample& sample)=0;
+	virtual void endFrame(const IngredientsType& ing){}
+
+	virtual void cleanup(const IngredientsType& ing, const std::string& dstdir)=0;
+
+protected:
+	struct PathSeparator
+	{
+		bool operator()(char ch) const
+		{
+			return ch == '\\' || ch == '/';
+		}
+	};
+
+	//! name of the input file without path and extension followed by suffix
+	static std::string getOutputName(const IngredientsType& ing, const std::string& suffix)
+	{
+		std::string filenameGeneral = std::string(std::find_if(ing.getName().rbegin(), ing.getName().rend(), PathSeparator()).base(), ing.getName().end());
+
+		std::string::size_type const p(filenameGeneral.find_last_of('.'));
+		return filenameGeneral.substr(0, p) + suffix;
+	}
+
+	static void writeFile(const IngredientsType& ing, const std::string& dstdir, const std::string& filename,
+	                      const std::vector<std::vector<double> >& results, const std::string& comment)
+	{
+		std::cout << " Write output to: " << dstdir << "/" << filename << std::endl;
+
+		ResultFormattingTools::writeResultFile(dstdir + "/" + filename, ing, results, comment);
+	}
+
+	//! number of cosolvent monomers in the current configuration
+	static int32_t countCosolvent(const IngredientsType& ing)
+	{
+		int32_t counterCosolvent = 0;
+		for (size_t n = 0; n < ing.getMolecules().size(); n++)
+			if (ing.getMolecules()[n].getAttributeTag() == 3)
+				counterCosolvent++;
+		return counterCosolvent;
+	}
+};
+
+/*****************************************************************************/
+/**
+ * @class ObserverCosolventContacts
+ * @brief cosolvent in the NN-shell of the polymer and cosolvent with more than one contact,
+ * same output as AnalyzerCounterNNShellContacts
+ * */
+/*****************************************************************************/
+template<class IngredientsType>
+class ObserverCosolventContacts : public NNShellObserver<IngredientsType>
+{
+public:
+	ObserverCosolventContacts():numberOfCosolventInShell(0), numberOfCosolventAsBridges(0)
+	{
+		Statistic_numCosolventInShell.clear();
+		Statistic_numCosolventAsBridge.clear();
+	}
+
+	virtual void beginFrame(const IngredientsType& ing)
+	{
+		numberOfCosolventInShell = 0;
+		numberOfCosolventAsBridges = 0;
+	}
+
+	virtual void addMonomer(const IngredientsType& ing, const NNShellSample& sample)
+	{
+		if (sample.numContacts > 0)
+			numberOfCosolventInShell++;
+		if (sample.numContacts > 1)
+			numberOfCosolventAsBridges++;
+	}
+
+	virtual void endFrame(const IngredientsType& ing)
+	{
+		Statistic_numCosolventInShell.AddValue(numberOfCosolventInShell);
+		Statistic_numCosolventAsBridge.AddValue(numberOfCosolventAsBridges);
+	}
+
+	virtual void cleanup(const IngredientsType& ing, const std::string& dstdir)
+	{
+		std::vector<std::vector<double> > tmpResults(5, std::vector<double>(1));
+
+		tmpResults[0][0] = this->countCosolvent(ing);
+		tmpResults[1][0] = Statistic_numCosolventInShell.ReturnM1();
+		tmpResults[2][0] = Statistic_numCosolventInShell.ReturnM2();
+		tmpResults[3][0] = Statistic_numCosolventAsBridge.ReturnM1();
+		tmpResults[4][0] = Statistic_numCosolventAsBridge.ReturnM2();
+
+		std::stringstream comment;
+		comment << "File produced by analyzer AnalyzerCounterNNShellContacts\n"
+				<< "Analyze CoSolventPolyereBridges\n"
+				<< "eta: Number of Cosolvent in NNShell in vicinity of polymere\n"
+				<< "gamma: Number of Bridge building Cosolvent with Polymere\n"
+				<< "\n"
+				<< "numCoSolvent\t<eta>\t<eta²>\t<gamma>\t<gamma^2>\n";
+
+		this->writeFile(ing, dstdir, this->getOutputName(ing, "_AnalyzerCounterNNShellContacts.dat"), tmpResults, comment.str());
+	}
+
+private:
+	StatisticMoment Statistic_numCosolventInShell;
+	StatisticMoment Statistic_numCosolventAsBridge;
+
+	int32_t numberOfCosolventInShell;
+	int32_t numberOfCosolventAsBridges;
+};
+
+/*****************************************************************************/
+/**
+ * @class ObserverCosolventBridges
+ * @brief cosolvent in the NN-shell of the polymer and cosolvent bridging distant monomers,
+ * same output as AnalyzerCounterNNShellBridges
+ * */
+/*****************************************************************************/
+template<class IngredientsType>
+class ObserverCosolventBridges : public NNShellObserver<IngredientsType>
+{
+public:
+	//! minContourSpan is only written to the header, the classification is done by the analyzer
+	ObserverCosolventBridges(uint32_t minContourSpan_ = 5):minContourSpan(minContourSpan_), numNetworkChains(0),
+		numberOfCosolventInShell(0), numberOfCosolventAsBridges(0), numberOfAnyBridges(0), numberOfInterChainBridges(0)
+	{
+		Statistic_numCosolventInShell.clear();
+		Statistic_numCosolventAsBridge.clear();
+		Statistic_numCosolventAsAnyBridge.clear();
+		Statistic_numCosolventAsInterChainBridge.clear();
+	}
+
+	virtual void initialize(const IngredientsType& ing, const ChainBridgeEngine& bridgeEngine)
+	{
+		contactsHistogram.reset(ChainBridgeEngine::MAX_CONTACTS + 1);
+		spanHistogram.reset(bridgeEngine.getMaxContourSpan() + 1);
+		numNetworkChains = bridgeEngine.getNumNetworkChains();
+	}
+
+	virtual void beginFrame(const IngredientsType& ing)
+	{
+		numberOfCosolventInShell = 0;
+		numberOfCosolventAsBridges = 0;
+		numberOfAnyBridges = 0;
+		numberOfInterChainBridges = 0;
+	}
+
+	virtual void addMonomer(const IngredientsType& ing, const NNShellSample& sample)
+	{
+		if (sample.numContacts > 0)
+			numberOfCosolventInShell++;
+		if (sample.bridge.isIntraChain)
+			numberOfCosolventAsBridges++;
+		if (sample.bridge.isInterChain)
+			numberOfInterChainBridges++;
+		if (sample.bridge.isBridge())
+			numberOfAnyBridges++;
+
+		contactsHistogram.add(sample.numContacts);
+		// at least one chain with two contacts
+		if (sample.bridge.numContacts > sample.bridge.numChains)
+			spanHistogram.add(sample.bridge.maxContourSpan);
+	}
+
+	virtual void endFrame(const IngredientsType& ing)
+	{
+		Statistic_numCosolventInShell.AddValue(numberOfCosolventInShell);
+		Statistic_numCosolventAsBridge.AddValue(numberOfCosolventAsBridges);
+		Statistic_numCosolventAsAnyBridge.AddValue(numberOfAnyBridges);
+		Statistic_numCosolventAsInterChainBridge.AddValue(numberOfInterChainBridges);
+	}
+
+	virtual void cleanup(const IngredientsType& ing, const std::string& dstdir)
+	{
+		std::vector<std::vector<double> > tmpResults(9, std::vector<double>(1));
+
+		tmpResults[0][0] = this->countCosolvent(ing);
+		tmpResults[1][0] = Statistic_numCosolventInShell.ReturnM1();
+		tmpResults[2][0] = Statistic_numCosolventInShell.ReturnM2();
+		tmpResults[3][0] = Statistic_numCosolventAsBridge.ReturnM1();
+		tmpResults[4][0] = Statistic_numCosolventAsBridge.ReturnM2();
+		tmpResults[5][0] = Statistic_numCosolventAsInterChainBridge.ReturnM1();
+		tmpResults[6][0] = Statistic_numCosolventAsInterChainBridge.ReturnM2();
+		tmpResults[7][0] = Statistic_numCosolventAsAnyBridge.ReturnM1();
+		tmpResults[8][0] = Statistic_numCosolventAsAnyBridge.ReturnM2();
+
+		// same header as the stand-alone analyzer
+		std::stringstream comment;
+		comment << "File produced by analyzer AnalyzerCounterNNShellContacts\n"
+				<< "Analyze CoSolventPolyereBridges\n"
+				<< "eta: Number of Cosolvent in NNShell in vicinity of polymere\n"
+				<< "gamma: Number of Bridge building Cosolvent with Polymere, contacts on one chain at least " << minContourSpan << " bonds apart along the shortest bond path\n"
+				<< "gamma_inter: contacts on at least two chains\n"
+				<< "gamma_any: gamma or gamma_inter\n";
+		if (numNetworkChains > 0)
+			comment << "spans on the " << numNetworkChains << " molecules with cycles other than rings are upper bounds along a spanning tree\n";
+		comment << "\n"
+				<< "numCoSolvent\t<eta>\t<eta²>\t<gamma>\t<gamma^2>\t<gamma_inter>\t<gamma_inter^2>\t<gamma_any>\t<gamma_any^2>\n";
+
+		this->writeFile(ing, dstdir, this->getOutputName(ing, "_AnalyzerCounterNNShellBridges.dat"), tmpResults, comment.str());
+
+		writeHistogram(ing, dstdir, "_AnalyzerCounterNNShellBridges_contacts.dat", contactsHistogram,
+		               "number of polymere contacts (diff*diff <= 6) per cosolvent and frame");
+		writeHistogram(ing, dstdir, "_AnalyzerCounterNNShellBridges_spans.dat", spanHistogram,
+		               "largest contour span of the contacts on one chain, cosolvent with at least two contacts on a chain");
+	}
+
+private:
+	uint32_t minContourSpan;
+
+	//! molecules whose contour spans are only upper bounds, see ChainBridgeEngine
+	size_t numNetworkChains;
+
+	StatisticMoment Statistic_numCosolventInShell;
+	StatisticMoment Statistic_numCosolventAsBridge;
+	StatisticMoment Statistic_numCosolventAsAnyBridge;
+	StatisticMoment Statistic_numCosolventAsInterChainBridge;
+
+	int32_t numberOfCosolventInShell;
+	int32_t numberOfCosolventAsBridges;
+	int32_t numberOfAnyBridges;
+	int32_t numberOfInterChainBridges;
+
+	IntegerHistogram contactsHistogram;
+	IntegerHistogram spanHistogram;
+
+	void writeHistogram(const IngredientsType& ing, const std::string& dstdir, const std::string& suffix,
+	                    const IntegerHistogram& histogram, const std::string& description) const
+	{
+		std::stringstream comment;
+		comment << "File produced by analyzer AnalyzerCounterNNShellContacts\n"
+				<< "Histogram of the " << description << "\n"
+				<< "samples: " << histogram.getNumSamples() << " mean: " << histogram.getMean()
+				<< " beyond the last bin: " << histogram.getNumOverflow() << "\n"
+				<< "\n"
+				<< "value\tcount\tfraction\n";
+
+		this->writeFile(ing, dstdir, this->getOutputName(ing, suffix), histogram.getColumns(), comment.str());
+	}
+};
+
+/*****************************************************************************/
+/**
+ * @class ObserverAdsorptionIsotherm
+ * @brief NN energy of the configuration and cosolvent with other species in the shell,
+ * same output as AnalyzerAdsorptionIsotherm
+ * */
+/*****************************************************************************/
+template<class IngredientsType>
+class ObserverAdsorptionIsotherm : public NNShellObserver<IngredientsType>
+{
+public:
+	ObserverAdsorptionIsotherm(uint32_t numCoSolvent_):numCoSolvent(numCoSolvent_), Energy(0.0), numCoSolventInShell(0.0), numVacantVerticesInShell(0.0)
+	{
+		Statistic_InternalEnergy.clear();
+		Statistic_NumMonomers.clear();
+	}
+
+	virtual bool observesAllMonomers() const {return true;}
+
+	virtual void beginFrame(const IngredientsType& ing)
+	{
+		Energy = 0.0;
+		numCoSolventInShell = 0.0;
+		numVacantVerticesInShell = 0.0;
+	}
+
+	virtual void addMonomer(const IngredientsType& ing, const NNShellSample& sample)
+	{
+		// summed site by site in the same order as the stand-alone analyzer
+		for (size_t contactNo = 0; contactNo < NNShellSample::NUM_SHELL_SITES; contactNo++)
+			if (sample.shellTags[contactNo] != 0)
+				Energy += sample.shellEnergies[contactNo];
+
+		// only for cosolvent: check if surrounding places are solvent (2) or polymer (1)
+		if (sample.tag == 3)
+		{
+			if (sample.numVacantSites > 0)
+				numCoSolventInShell++;
+			numVacantVerticesInShell += sample.numVacantSites;
+		}
+	}
+
+	virtual void endFrame(const IngredientsType& ing)
+	{
+		// factor 0.5 due to the double sum in hamiltonian
+		Statistic_InternalEnergy.AddValue(0.5 * Energy);
+		Statistic_NumMonomers.AddValue(numCoSolventInShell);
+
+		std::cout << " numVacantVerticesInShell: " << numVacantVerticesInShell << std::endl;
+	}
+
+	virtual void cleanup(const IngredientsType& ing, const std::string& dstdir)
+	{
+		std::cout << "Average Values: = " << Statistic_InternalEnergy.ReturnN() << std::endl;
+
+		std::vector<std::vector<double> > tmpResults(12, std::vector<double>(1));
+
+		tmpResults[0][0] = ing.getNNInteraction(2, 3);
+		tmpResults[1][0] = Statistic_InternalEnergy.ReturnM1();
+		tmpResults[2][0] = Statistic_InternalEnergy.ReturnM2();
+		tmpResults[3][0] = Statistic_InternalEnergy.ReturnM2() - Statistic_InternalEnergy.ReturnM1() * Statistic_InternalEnergy.ReturnM1();
+
+		tmpResults[4][0] = Statistic_InternalEnergy.ReturnM1() / ing.getNNInteraction(2, 3);
+
+		tmpResults[5][0] = numCoSolvent;
+
+		tmpResults[6][0] = Statistic_NumMonomers.ReturnM1();
+		tmpResults[7][0] = Statistic_NumMonomers.ReturnM2();
+		tmpResults[8][0] = Statistic_NumMonomers.ReturnM2() - Statistic_NumMonomers.ReturnM1() * Statistic_NumMonomers.ReturnM1();
+
+		tmpResults[9][0] = Statistic_NumMonomers.ReturnM1() / numCoSolvent;
+
+		tmpResults[10][0] = ((8.0 * (ing.getMolecules().size())) / (1.0 * ing.getBoxX() * ing.getBoxY() * ing.getBoxZ()));
+
+		tmpResults[11][0] = 8.0 * numCoSolvent / (1.0 * ing.getBoxX() * ing.getBoxY() * ing.getBoxZ());
+
+		std::stringstream comment;
+		comment << "File produced by analyzer AnalyzerAdsorptionIsotherm\n"
+				<< "Analyze AdsorptionIsotherm\n"
+				<< "NrDensity c=" << ((8.0 * (ing.getMolecules().size())) / (ing.getBoxX() * ing.getBoxY() * ing.getBoxZ())) << "\n"
+				<< "Number CoSolvency=" << numCoSolvent << "\n"
+				<< "\n"
+				<< "epsilon\t<U>\t<U²>\t<cV>\t<nContacts>\t<nCoSolvent>\t<nCoS In NNShell>\t<(nCoS In NNShell)²>\tvar(nCoS In NNShell)\t<(nCoS In NNShell)/nCoSolvent>\t<cAll>\t<cCoSolvent>\n";
+
+		this->writeFile(ing, dstdir, this->getOutputName(ing, "_AnalyzerHeatCapacityNNShellContactsCoSolvent.dat"), tmpResults, comment.str());
+	}
+
+private:
+	uint32_t numCoSolvent;
+
+	StatisticMoment Statistic_InternalEnergy;
+	StatisticMoment Statistic_NumMonomers;
+
+	double Energy;
+	double numCoSolventInShell;
+	double numVacantVerticesInShell;
+};
+
+#endif /*NNShellObservers_H*/
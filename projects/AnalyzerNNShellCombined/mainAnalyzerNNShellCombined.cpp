@@ -0,0 +1,136 @@
+#include <cstring>
+
+#include <iostream>
+#include <iomanip>
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+#include <LeMonADE/core/ConfigureSystem.h>
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureNNInteractionSc.h>
+#include <LeMonADE/utility/TaskManager.h>
+#include <LeMonADE/updater/UpdaterReadBfmFile.h>
+
+#include "catchorg/clara/clara.hpp"
+
+#include "AnalyzerNNShellCombined.h"
+
+
+
+int main(int argc, char* argv[])
+{
+	try{
+		std::string infile  = "input.bfm";
+
+		uint64_t startAge = 0;
+		uint32_t numCoSolvent = 1024;
+		uint32_t minContourSpan = 5;
+
+		bool noContacts = false;
+		bool noBridges = false;
+		bool noIsotherm = false;
+
+		bool showHelp = false;
+
+		auto parser
+		= clara::Opt( infile, "input (=input.bfm)" )
+		["-i"]["--infile"]
+			   ("BFM-file to load.")
+			   .required()
+		| clara::Opt( startAge, "start MCS(=0)" )
+		["-s"]["--startAge"]
+			   ("(required) first Monte-Carlo step that is analysed.")
+			   .required()
+		| clara::Opt( [&numCoSolvent](int const n)
+					   {
+			if (n <= 0)
+			{
+				return clara::ParserResult::runtimeError("Number of CoSolvent must be greater than 0");
+			}
+			else
+			{
+				numCoSolvent = n;
+				return clara::ParserResult::ok(clara::ParseResultType::Matched);
+			}
+					   }, "(=1024)")
+		["-n"]["--number-cosolvent"]
+			   ("Number of CoSolvent used for the normalization of the adsorption isotherm." )
+		| clara::Opt( [&minContourSpan](int const b)
+					   {
+			if (b < 1)
+			{
+				return clara::ParserResult::runtimeError("Minimum contour span of a bridge must be greater than 0.");
+			}
+			else
+			{
+				minContourSpan = b;
+				return clara::ParserResult::ok(clara::ParseResultType::Matched);
+			}
+					   }, "span(=5)" )
+		["-b"]["--min-span"]
+			   ("minimum number of bonds along the chain between two contacts of an intra-chain bridge.")
+		| clara::Opt( noContacts )
+		["--no-contacts"]
+			   ("do not write _AnalyzerCounterNNShellContacts.dat")
+		| clara::Opt( noBridges )
+		["--no-bridges"]
+			   ("do not write _AnalyzerCounterNNShellBridges.dat")
+		| clara::Opt( noIsotherm )
+		["--no-isotherm"]
+			   ("do not write _AnalyzerHeatCapacityNNShellContactsCoSolvent.dat (the NN-shell is then only read around cosolvent)")
+		 | clara::Help( showHelp );
+
+		auto result = parser.parse( clara::Args( argc, argv ) );
+		if( !result ) {
+			std::cerr << "Error in command line: " << result.errorMessage() << std::endl;
+			exit(1);
+		}
+		else if(showHelp == true)
+		{
+			std::cout << "Contacts, bridges and adsorption isotherm of the cosolvent in one pass over the trajectory" << std::endl
+					<< "writes the files of AnalyzerCounterNNShellContacts, AnalyzerCounterNNShellBridges and AnalyzerAdsorptionIsotherm" << std::endl;
+
+			parser.writeToStream(std::cout);
+			exit(0);
+		}
+		else
+		{
+			std::cout << "infile:        " << infile << std::endl
+					<< "startAge:      " << startAge << std::endl
+					<< "numCoSolvent:  " << numCoSolvent << std::endl
+					<< "minContourSpan: " << minContourSpan << std::endl
+					;
+		}
+
+	//seed the globally available random number generators
+	RandomNumberGenerators rng;
+	rng.seedAll();
+
+	typedef LOKI_TYPELIST_3(FeatureMoleculesIO, FeatureAttributes< >, FeatureNNInteractionSc< FeatureLattice >) Features;
+
+	typedef ConfigureSystem<VectorInt3,Features, 2> Config;
+	typedef Ingredients<Config> Ing;
+	Ing myIngredients;
+
+	AnalyzerNNShellCombined<Ing>* analyzer = new AnalyzerNNShellCombined<Ing>(myIngredients, startAge, "./", minContourSpan);
+	if(!noContacts)
+		analyzer->addObserver(new ObserverCosolventContacts<Ing>());
+	if(!noBridges)
+		analyzer->addObserver(new ObserverCosolventBridges<Ing>(minContourSpan));
+	if(!noIsotherm)
+		analyzer->addObserver(new ObserverAdsorptionIsotherm<Ing>(numCoSolvent));
+
+	TaskManager taskmanager;
+	taskmanager.addUpdater(new UpdaterReadBfmFile<Ing>(infile, myIngredients,UpdaterReadBfmFile<Ing>::READ_STEPWISE));
+	taskmanager.addAnalyzer(analyzer);
+
+	taskmanager.initialize();
+	taskmanager.run();
+	taskmanager.cleanup();
+
+	}
+	catch(std::exception& err){std::cerr<<err.what();}
+	return 0;
+
+}
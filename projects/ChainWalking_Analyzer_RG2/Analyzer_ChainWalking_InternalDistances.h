@@ -0,0 +1,392 @@
+/* **************************************************************
+ * Analyzer for the internal distances of linear chains
+ *
+ * Calculates the mean square distance <R^2(n)> between monomers that are n
+ * bonds apart along the contour of the linear chains in the system, and the
+ * time autocorrelation of the end-to-end vectors up to a maximum lag.
+ * *************************************************************/
+
+#ifndef ANALYZER_CHAIN_WALKING_INTERNAL_DISTANCES_H
+#define ANALYZER_CHAIN_WALKING_INTERNAL_DISTANCES_H
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <LeMonADE/utility/Vector3D.h>
+#include <LeMonADE/analyzer/AbstractAnalyzer.h>
+#include <LeMonADE/utility/ResultFormattingTools.h>
+#include <sstream>
+#include <stdexcept>
+#include <stdint.h>
+
+#include "InternalDistances.h"
+#include "MoleculeIndex.h"
+#include "ParallelTasks.h"
+#include "UnwrappedCoordinates.h"
+
+
+/*****************************************************************************
+ * CLASS DEFINITION (implementation of methods below)
+ * **************************************************************************/
+
+template<class IngredientsType>
+class Analyzer_ChainWalking_InternalDistances:public AbstractAnalyzer
+{
+public:
+  //constuctor
+  Analyzer_ChainWalking_InternalDistances(const IngredientsType& ing, long evalulation_time_, uint32_t numThreads_=1,
+                                          uint32_t maxCorrelationLag_=100, uint32_t skip_=0);
+
+  //finds the linear chains. called explicitly or by Taskmanager::init()
+  virtual void initialize();
+
+  //does all the calculations esp in every !mcs
+  virtual bool execute();
+
+  //write out your results
+  virtual void cleanup();
+
+private:
+
+ //holds a reference of the complete system
+ const IngredientsType& ingredients;
+
+ //only used to make sure you initialize your analyzer before you do things
+ bool initialized;
+
+ long evalulation_time;
+
+ uint32_t numThreads;
+
+ //linear chains with at least two monomers, the monomers of chain c in contour order are
+ //chainMonomers[chainOffsets[c]..chainOffsets[c+1]-1], starting at the end with the lower index
+ MoleculeIndex moleculeIndex;
+ std::vector<size_t> chainOffsets;
+ std::vector<uint32_t> chainMonomers;
+ size_t maxChainLength;
+
+ size_t GetNumChains() const {return chainOffsets.size()-1;}
+
+ //unwrapped coordinates of all chain monomers of the current frame, one contiguous block per chain
+ UnwrappedCoordinates unwrappedCoordinates;
+ std::vector<int32_t> chainX, chainY, chainZ;
+
+ //exact sums of the current frame per thread and the sums over all frames for every separation n
+ std::vector< std::vector<int64_t> > threadSumR2;
+ std::vector<double> sumR2;
+ std::vector<uint64_t> numPairs;
+
+ //end-to-end vectors of the last maxCorrelationLag+1 frames (ring buffer) and their ages
+ uint32_t maxCorrelationLag;
+ std::vector<int32_t> endToEnd;
+ std::vector<uint64_t> endToEndAge;
+
+ //sums of R_e(t)*R_e(t-lag) over chains and frame pairs and of the time differences in MCS
+ std::vector<double> sumCorrelation;
+ std::vector<double> sumLagTime;
+ std::vector<uint64_t> numCorrelationValues;
+
+ uint32_t nValues;
+
+ //only every (skip+1)-th frame is analysed, counted by frameCounter
+ uint32_t skip;
+ uint64_t frameCounter;
+
+ void FindLinearChains();
+ void CalcInternalDistances();
+ void CalcEndToEndCorrelation();
+};
+
+
+/*****************************************************************************
+ * IMPLEMENTATION OF METHODS
+ * **************************************************************************/
+
+/* ****************************************************************************
+ * constructor. only initializes some variables
+ * ***************************************************************************/
+template<class IngredientsType>
+Analyzer_ChainWalking_InternalDistances<IngredientsType>::Analyzer_ChainWalking_InternalDistances(const IngredientsType& ing, long evalulation_time_,
+                                                                                                  uint32_t numThreads_, uint32_t maxCorrelationLag_, uint32_t skip_)
+ :ingredients(ing),initialized(false),evalulation_time(evalulation_time_),numThreads(numThreads_ > 0 ? numThreads_ : 1),
+  maxChainLength(0),maxCorrelationLag(maxCorrelationLag_),nValues(0),skip(skip_),frameCounter(0)
+{
+}
+
+/* **********************************************************************
+ * initialize()
+ *
+ * this is called in the beginning only once - finds the chains and sets up the sums
+ * **********************************************************************/
+template<class IngredientsType>
+void Analyzer_ChainWalking_InternalDistances<IngredientsType>::initialize()
+{
+	FindLinearChains();
+
+	chainX.resize(chainMonomers.size());
+	chainY.resize(chainMonomers.size());
+	chainZ.resize(chainMonomers.size());
+
+	threadSumR2.assign(numThreads, std::vector<int64_t>(maxChainLength, 0));
+	sumR2.assign(maxChainLength, 0.0);
+
+	// number of monomer pairs with separation n in one frame
+	numPairs.assign(maxChainLength, 0);
+	for(size_t c = 0; c < GetNumChains(); c++)
+		for(size_t n = 1; n < chainOffsets[c+1]-chainOffsets[c]; n++)
+			numPairs[n] += chainOffsets[c+1]-chainOffsets[c]-n;
+
+	endToEnd.assign(size_t(maxCorrelationLag+1)*3*GetNumChains(), 0);
+	endToEndAge.assign(maxCorrelationLag+1, 0);
+	sumCorrelation.assign(maxCorrelationLag+1, 0.0);
+	sumLagTime.assign(maxCorrelationLag+1, 0.0);
+	numCorrelationValues.assign(maxCorrelationLag+1, 0);
+
+	nValues = 0;
+	frameCounter = 0;
+
+	std::cout << "Analyzer_ChainWalking_InternalDistances: " << GetNumChains() << " linear chains with up to "
+			  << maxChainLength << " monomers on " << numThreads << " threads" << std::endl;
+
+	initialized = true;
+}
+
+/* ***********************************************************************
+ * execute()
+ * this is where the calculation happens
+ * ***********************************************************************/
+template<class IngredientsType>
+bool Analyzer_ChainWalking_InternalDistances<IngredientsType>::execute()
+{
+	if(initialized==false)
+	{
+		std::stringstream errormessage;
+		errormessage<<"Analyzer_ChainWalking_InternalDistances::execute()...Analyzer_ChainWalking_InternalDistances not initialized\n"
+			    <<"Use Analyzer_ChainWalking_InternalDistances::initialize() or Taskmanager::init()\n";
+		throw std::runtime_error(errormessage.str());
+	}
+
+	// the image flags follow every frame, also the skipped ones
+	if(!unwrappedCoordinates.isInitialized())
+		unwrappedCoordinates.initialize(ingredients, moleculeIndex);
+	else
+		unwrappedCoordinates.update(ingredients, moleculeIndex);
+
+	if((frameCounter++) % (skip+1) != 0)
+		return true;
+
+	//wait relaxation time
+	if(ingredients.getMolecules().getAge() > evalulation_time)
+	{
+		std::cout << "Analyzer_ChainWalking_InternalDistances.execute() at MCS:" << ingredients.getMolecules().getAge() << std::endl;
+
+		// contiguous coordinate block of every chain
+		for(size_t k = 0; k < chainMonomers.size(); k++)
+		{
+			const VectorInt3 pos = unwrappedCoordinates.getPosition(chainMonomers[k]);
+			chainX[k] = pos.getX();
+			chainY[k] = pos.getY();
+			chainZ[k] = pos.getZ();
+		}
+
+		CalcInternalDistances();
+		CalcEndToEndCorrelation();
+
+		nValues++;
+	}
+
+	return true;
+}
+
+/****************************************************************************
+ * cleanup
+ * writes <R^2(n)> to _InternalDistances.dat and the end-to-end vector
+ * autocorrelation to _EndToEndCorrelation.dat
+ * *************************************************************************/
+template<class IngredientsType>
+void Analyzer_ChainWalking_InternalDistances<IngredientsType>::cleanup()
+{
+	std::cout << "Analyzer_ChainWalking_InternalDistances.cleanup() " << std::endl;
+	if(unwrappedCoordinates.getNumRepairs() > 0)
+		std::cout << unwrappedCoordinates.getNumRepairs() << " times a molecule was unwrapped again along its bonds (monomers moved half a box length between frames)" << std::endl;
+
+	// get the filename and path
+	std::string filenameGeneral=ingredients.getName();
+	// delete the .bfm in the name
+	filenameGeneral.erase (ingredients.getName().length()-4, ingredients.getName().length());
+
+	std::vector < std::vector<double> > distances(4);
+	for(size_t n = 1; n < maxChainLength; n++)
+	{
+		if(numPairs[n] == 0)
+			continue;
+		const double meanR2 = sumR2[n]/(double(numPairs[n])*double(nValues));
+		distances[0].push_back(n);
+		distances[1].push_back(meanR2);
+		distances[2].push_back(meanR2/double(n));
+		distances[3].push_back(double(numPairs[n])*double(nValues));
+	}
+
+	const double meanEndToEnd2 = (numCorrelationValues[0] > 0) ? sumCorrelation[0]/double(numCorrelationValues[0]) : 0.0;
+	std::cout << "Average squared end-to-end distance <R_e^2> = " << meanEndToEnd2 << std::endl;
+
+	std::stringstream comment;
+	comment << "File produced by analyzer Analyzer_ChainWalking_InternalDistances" << std::endl
+			<< "Internal mean square distances of " << GetNumChains() << " linear chains in " << nValues << " frames" << std::endl
+			<< "Average squared end-to-end distance <R_e^2>=" << meanEndToEnd2 << std::endl
+			<< std::endl
+			<< "n <R^2(n)> <R^2(n)>/n pairs";
+
+	ResultFormattingTools::writeResultFile(filenameGeneral + "_InternalDistances.dat", this->ingredients, distances, comment.str());
+
+	std::vector < std::vector<double> > correlation(5);
+	for(size_t lag = 0; lag <= maxCorrelationLag; lag++)
+	{
+		if(numCorrelationValues[lag] == 0)
+			continue;
+		const double meanCorrelation = sumCorrelation[lag]/double(numCorrelationValues[lag]);
+		correlation[0].push_back(lag);
+		correlation[1].push_back(sumLagTime[lag]/double(numCorrelationValues[lag]/GetNumChains()));
+		correlation[2].push_back(meanCorrelation);
+		correlation[3].push_back(meanEndToEnd2 > 0.0 ? meanCorrelation/meanEndToEnd2 : 0.0);
+		correlation[4].push_back(numCorrelationValues[lag]);
+	}
+
+	std::stringstream comment2;
+	comment2 << "File produced by analyzer Analyzer_ChainWalking_InternalDistances" << std::endl
+			<< "Autocorrelation of the end-to-end vectors of " << GetNumChains() << " linear chains, lag in analysed frames up to " << maxCorrelationLag << std::endl
+			<< "Average squared end-to-end distance <R_e^2>=" << meanEndToEnd2 << std::endl
+			<< std::endl
+			<< "lag <dt/MCS> <R_e(t)*R_e(t+dt)> <R_e(t)*R_e(t+dt)>/<R_e^2> samples";
+
+	ResultFormattingTools::writeResultFile(filenameGeneral + "_EndToEndCorrelation.dat", this->ingredients, correlation, comment2.str());
+}
+
+/****************************************************************************
+ * FindLinearChains
+ * molecules from the bonds of the first frame in which every monomer has at
+ * most two bonds and which contain no ring. Each chain is stored in contour
+ * order starting at the end with the lower index.
+ * *************************************************************************/
+template<class IngredientsType>
+void Analyzer_ChainWalking_InternalDistances<IngredientsType>::FindLinearChains()
+{
+	moleculeIndex.build(ingredients.getMolecules());
+
+	chainOffsets.assign(1, 0);
+	chainMonomers.clear();
+	maxChainLength = 0;
+	size_t numOtherMolecules = 0;
+
+	for(size_t m = 0; m < moleculeIndex.getNumMolecules(); m++)
+	{
+		const size_t size = moleculeIndex.getMoleculeSize(m);
+		const uint32_t* block = moleculeIndex.getMonomers(m);
+		if(size < 2)
+			continue;
+
+		size_t numLinks = 0;
+		bool linear = true;
+		uint32_t start = uint32_t(-1);
+		for(size_t k = 0; k < size; k++)
+		{
+			const size_t links = ingredients.getMolecules().getNumLinks(block[k]);
+			numLinks += links;
+			if(links > 2)
+				linear = false;
+			if(links == 1 && block[k] < start)
+				start = block[k];
+		}
+		// a connected molecule with size-1 bonds is a tree, with at most two bonds per monomer a chain
+		if(!linear || numLinks != 2*(size-1))
+		{
+			numOtherMolecules++;
+			continue;
+		}
+
+		uint32_t previous = start;
+		uint32_t current = start;
+		for(size_t k = 0; k < size; k++)
+		{
+			chainMonomers.push_back(current);
+			uint32_t next = current;
+			for(size_t l = 0; l < ingredients.getMolecules().getNumLinks(current); l++)
+				if(ingredients.getMolecules().getNeighborIdx(current, l) != previous)
+					next = ingredients.getMolecules().getNeighborIdx(current, l);
+			previous = current;
+			current = next;
+		}
+		chainOffsets.push_back(chainMonomers.size());
+		maxChainLength = std::max(maxChainLength, size);
+	}
+
+	if(numOtherMolecules > 0)
+		std::cout << "Analyzer_ChainWalking_InternalDistances: " << numOtherMolecules << " branched or cyclic molecules are left out" << std::endl;
+}
+
+/****************************************************************************
+ * CalcInternalDistances
+ * The chains are distributed onto the threads, every thread sums into its
+ * own exact integer sums, which are added to the averages afterwards.
+ * *************************************************************************/
+template<class IngredientsType>
+void Analyzer_ChainWalking_InternalDistances<IngredientsType>::CalcInternalDistances()
+{
+	ParallelTasks::parallelFor(GetNumChains(), numThreads, [&](size_t c, uint32_t threadId){
+		const size_t offset = chainOffsets[c];
+		InternalDistances::addAllSeparations(&chainX[offset], &chainY[offset], &chainZ[offset],
+		                                     chainOffsets[c+1]-offset, &threadSumR2[threadId][0]);
+	});
+
+	for(size_t n = 1; n < maxChainLength; n++)
+	{
+		int64_t frameSum = 0;
+		for(uint32_t t = 0; t < numThreads; t++)
+		{
+			frameSum += threadSumR2[t][n];
+			threadSumR2[t][n] = 0;
+		}
+		sumR2[n] += double(frameSum);
+	}
+}
+
+/****************************************************************************
+ * CalcEndToEndCorrelation
+ * stores the end-to-end vectors of the frame in the ring buffer and adds
+ * R_e(t)*R_e(t-lag) of every chain for all lags to frames still in the buffer
+ * *************************************************************************/
+template<class IngredientsType>
+void Analyzer_ChainWalking_InternalDistances<IngredientsType>::CalcEndToEndCorrelation()
+{
+	const size_t numChains = GetNumChains();
+	if(numChains == 0)
+		return;
+	const size_t ringSize = maxCorrelationLag+1;
+	const size_t slot = nValues % ringSize;
+
+	int32_t* current = &endToEnd[3*numChains*slot];
+	for(size_t c = 0; c < numChains; c++)
+	{
+		const size_t first = chainOffsets[c];
+		const size_t last = chainOffsets[c+1]-1;
+		current[3*c]   = chainX[last]-chainX[first];
+		current[3*c+1] = chainY[last]-chainY[first];
+		current[3*c+2] = chainZ[last]-chainZ[first];
+	}
+	endToEndAge[slot] = ingredients.getMolecules().getAge();
+
+	for(size_t lag = 0; lag <= std::min<size_t>(nValues, maxCorrelationLag); lag++)
+	{
+		const size_t earlierSlot = (slot+ringSize-lag) % ringSize;
+		const int32_t* earlier = &endToEnd[3*numChains*earlierSlot];
+		int64_t sum = 0;
+		for(size_t i = 0; i < 3*numChains; i++)
+			sum += int64_t(current[i])*earlier[i];
+		sumCorrelation[lag] += double(sum);
+		sumLagTime[lag] += double(endToEndAge[slot]-endToEndAge[earlierSlot]);
+		numCorrelationValues[lag] += numChains;
+	}
+}
+
+#endif /*ANALYZER_CHAIN_WALKING_INTERNAL_DISTANCES_H*/
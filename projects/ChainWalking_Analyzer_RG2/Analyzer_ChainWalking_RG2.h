@@ -15,6 +15,17 @@
 #include <LeMonADE/analyzer/AbstractAnalyzer.h>
 #include <LeMonADE/utility/ResultFormattingTools.h>
 #include <fstream>
+#include <cmath>
+#include <memory>
+#include <stdint.h>
+
+#include "BondVectorStatistics.h"
+#include "ColumnSeriesWriter.h"
+#include "GyrationTensor.h"
+#include "MoleculeIndex.h"
+#include "OrderedFramePipeline.h"
+#include "ParallelTasks.h"
+#include "UnwrappedCoordinates.h"
 
 
 /*****************************************************************************
@@ -25,9 +36,35 @@ template<class IngredientsType>
 class Analyzer_ChainWalking_RG2:public AbstractAnalyzer
 {
 public:
+  //! MOMENTS: single pass over the first and second moments, PAIR_SUM: double sum over all pairs for validation
+  enum Rg2Method {MOMENTS=0, PAIR_SUM=1};
+
+  //! attribute tags of the monomers of every group, Rg2 is evaluated for each group separately
+  typedef std::vector< std::vector<int32_t> > TagGroups;
 	
+  //! settings of the analysis, the defaults evaluate the Rg2 of the monomers with attribute 1 on one thread
+  struct Options {
+	  Rg2Method method;
+	  //! Rg2 distribution of the single molecules with monomers of the first group
+	  bool perMolecule;
+	  uint32_t numThreads;
+	  double moleculeRg2BinWidth;
+	  //! unwrap the positions across periodic borders, otherwise the raw coordinates are used
+	  bool unwrap;
+	  //! only every (skip+1)-th frame is analysed
+	  uint32_t skip;
+	  //! series of Rg2 and eigenvalues to _Rg2_all.bin instead of _Rg2_all.dat
+	  bool binarySeries;
+	  //! evaluate whole frames on the numThreads threads instead of the molecules of one frame
+	  bool frameParallel;
+	  TagGroups tagGroups;
+
+	  Options():method(MOMENTS),perMolecule(false),numThreads(1),moleculeRg2BinWidth(1.0),unwrap(true),skip(0),
+	           binarySeries(false),frameParallel(false),tagGroups(1, std::vector<int32_t>(1, 1)){}
+  };
+
   //constuctor
-  Analyzer_ChainWalking_RG2(const IngredientsType& ing, long evalulation_time_);
+  Analyzer_ChainWalking_RG2(const IngredientsType& ing, long evalulation_time_, const Options& options=Options());
     
   //initializes the groups. called explicitly or by Taskmanager::init()
   virtual void initialize();
@@ -46,26 +83,127 @@ private:
  const IngredientsType& ingredients;
 
  
- //for calculating the average RgSquared and the components
- double sumRg2;
- double sumRg2_x;
- double sumRg2_y;
- double sumRg2_z;
- 
+ //Rg2, its components, the eigenvalues of the gyration tensor and the shape descriptors of one group
+ //in one frame, also used for the sums over all frames
+ struct GroupValues {
+	 double Rg2, Rg2_x, Rg2_y, Rg2_z;
+	 double lambda[3];
+	 double asphericity, acylindricity, shapeAnisotropy;
+
+	 GroupValues():Rg2(0.0),Rg2_x(0.0),Rg2_y(0.0),Rg2_z(0.0),asphericity(0.0),acylindricity(0.0),shapeAnisotropy(0.0)
+	 {
+		 lambda[0] = lambda[1] = lambda[2] = 0.0;
+	 }
+ };
+
+ //for calculating the averages of every group
+ std::vector<GroupValues> groupSums;
  
  uint32_t nValues;
  
+ //bonds of the first frame, <b^2> and the occupancy of the 108 bond vectors
+ BondVectorStatistics bondStatistics;
+ BondVectorStatistics::Sums bondSums;
  double sumBondLength2;
- uint32_t nValuesBondLength2;
+
+ void WriteBondVectors(const std::string& filenameGeneral);
 
  //only used to make sure you initialize your groups before you do things
  bool initialized;
 
  long evalulation_time;
 
- std::vector<double> Rg_2_state; // all Rg2 for every frame
-
- int looped_over_monomers; //counts the monomers that had attribute 1
+ //Rg2 and the eigenvalues of every frame are streamed to _Rg2_all.dat (or .bin), the memory does not grow with the trajectory
+ bool binarySeries;
+ std::unique_ptr<ColumnSeriesWriter> seriesWriter;
+ std::vector<double> seriesRow;
+
+ //groups of attribute tags, the lookup table tag -> group (or -1) and the group of every monomer,
+ //the attributes do not change during the trajectory
+ TagGroups tagGroups;
+ std::vector<int32_t> tagToGroup;
+ std::vector<int32_t> monomerGroup;
+ std::vector< std::vector<uint32_t> > groupMonomers;
+
+ //column name with the tags of group g appended if there is more than one group
+ std::string ColumnName(const std::string& name, size_t g) const;
+
+ Rg2Method method;
+
+ //largest difference between pair sum and moments in PAIR_SUM mode
+ double maxDeviationPairSum;
+
+ //coordinates of all monomers in one frame, unwrapped if unwrap is set
+ struct FrameData {
+	 std::vector<int32_t> x, y, z;
+ };
+
+ //everything the averages need from one frame
+ struct FrameResult {
+	 std::vector<GroupValues> groups;
+	 double deviationPairSum;
+	 BondVectorStatistics::Sums bondSums;
+	 std::vector<double> moleculeRg2;
+	 std::vector<double> moleculeRg2Components;
+ };
+
+ //copies the frame in blocks of monomers on the threads of gatherPool
+ void GatherPositions(FrameData& frame);
+
+ //threads of the per frame O(N) work on the reading thread: following the image
+ //flags and copying the positions, also with frameParallel
+ ParallelTasks::ThreadPool gatherPool;
+ enum {GATHER_BLOCK = 4096};
+
+ //evaluates one frame without touching the averages, may run on any thread
+ void AnalyseFrame(const FrameData& frame, FrameResult& result, uint32_t moleculeThreads) const;
+
+ //adds the result of one frame to the averages and the series, called in frame order
+ void AccumulateFrame(const FrameResult& result);
+
+ //first and second moments of every group in one pass, exact in integer arithmetic
+ void CalcGyrationMoments(const FrameData& frame, std::vector<GyrationMoments>& moments) const;
+ void CalcRg2PairSum(const FrameData& frame, const std::vector<uint32_t>& monomers, double& N2Rg2_x, double& N2Rg2_y, double& N2Rg2_z) const;
+
+ //with frameParallel the frames are evaluated on numThreads threads and accumulated in order
+ bool frameParallel;
+ std::unique_ptr< OrderedFramePipeline<FrameData,FrameResult> > pipeline;
+ FrameData currentFrame;
+ FrameResult currentResult;
+
+ //Rg2 of every single molecule with monomers of the first group, in addition to the whole structure
+ bool perMolecule;
+ uint32_t numThreads;
+ double moleculeRg2BinWidth;
+
+ //molecules from the bonds of the first frame, the topology does not change
+ MoleculeIndex moleculeIndex;
+ std::vector<uint32_t> rg2Molecules;
+
+ //distribution of the molecule Rg2 with bin width moleculeRg2BinWidth and the ensemble averages
+ std::vector<uint64_t> moleculeRg2Histogram;
+ double sumMoleculeRg2;
+ double sumMoleculeRg2_x;
+ double sumMoleculeRg2_y;
+ double sumMoleculeRg2_z;
+ uint64_t nMoleculeValues;
+
+ void CalcMoleculeRg2(const FrameData& frame, FrameResult& result, uint32_t moleculeThreads) const;
+ void WriteMoleculeRg2(const std::string& filenameGeneral);
+
+ //positions are unwrapped incrementally, so execute() has to be called for every frame
+ bool unwrap;
+ UnwrappedCoordinates unwrappedCoordinates;
+
+ //only every (skip+1)-th frame is analysed, counted by frameCounter
+ uint32_t skip;
+ uint64_t frameCounter;
+
+ //position of monomer k, unwrapped if unwrap is set
+ VectorInt3 GetPosition(size_t k) const
+ {
+	 return unwrap ? unwrappedCoordinates.getPosition(k) : VectorInt3(ingredients.getMolecules()[k]);
+ }
 };
 
 
@@ -79,9 +217,33 @@ private:
  * constructor. only initializes some variables
  * ***************************************************************************/
 template<class IngredientsType>
-Analyzer_ChainWalking_RG2<IngredientsType>::Analyzer_ChainWalking_RG2(const IngredientsType& ing, long evalulation_time_)
- :ingredients(ing),initialized(false),sumRg2(0.0),nValues(0),evalulation_time(evalulation_time_)
+Analyzer_ChainWalking_RG2<IngredientsType>::Analyzer_ChainWalking_RG2(const IngredientsType& ing, long evalulation_time_, const Options& options)
+ :ingredients(ing),nValues(0),initialized(false),evalulation_time(evalulation_time_),binarySeries(options.binarySeries),tagGroups(options.tagGroups),method(options.method),maxDeviationPairSum(0.0),frameParallel(options.frameParallel),
+  perMolecule(options.perMolecule),numThreads(options.numThreads > 0 ? options.numThreads : 1),moleculeRg2BinWidth(options.moleculeRg2BinWidth),
+  unwrap(options.unwrap),skip(options.skip),frameCounter(0)
 {
+	if(moleculeRg2BinWidth <= 0.0)
+		throw std::runtime_error("Analyzer_ChainWalking_RG2: bin width of the molecule Rg2 histogram must be positive");
+	if(tagGroups.empty())
+		throw std::runtime_error("Analyzer_ChainWalking_RG2: at least one group of attribute tags is needed");
+
+	// lookup table tag -> group, every tag can only belong to one group
+	for(size_t g = 0; g < tagGroups.size(); g++)
+	{
+		if(tagGroups[g].empty())
+			throw std::runtime_error("Analyzer_ChainWalking_RG2: empty group of attribute tags");
+		for(size_t t = 0; t < tagGroups[g].size(); t++)
+		{
+			const int32_t tag = tagGroups[g][t];
+			if(tag < 0)
+				throw std::runtime_error("Analyzer_ChainWalking_RG2: attribute tags of the groups must not be negative");
+			if(size_t(tag) >= tagToGroup.size())
+				tagToGroup.resize(tag+1, -1);
+			if(tagToGroup[tag] >= 0 && tagToGroup[tag] != int32_t(g))
+				throw std::runtime_error("Analyzer_ChainWalking_RG2: an attribute tag is used in more than one group");
+			tagToGroup[tag] = g;
+		}
+	}
 }
 
 /* **********************************************************************
@@ -92,19 +254,95 @@ Analyzer_ChainWalking_RG2<IngredientsType>::Analyzer_ChainWalking_RG2(const Ingr
 template<class IngredientsType>
 void Analyzer_ChainWalking_RG2<IngredientsType>::initialize()
 {
-	sumRg2 = 0.0;
-	sumRg2_x = 0.0;
-	sumRg2_y = 0.0;
-	sumRg2_z = 0.0;
+	groupSums.assign(tagGroups.size(), GroupValues());
 
 	nValues = 0;
 	
 	sumBondLength2 = 0.0;
-	nValuesBondLength2 = 0;
+	bondStatistics.build(ingredients.getMolecules());
+	bondSums.clear();
+
+	// every monomer is dispatched to its group once
+	monomerGroup.assign(ingredients.getMolecules().size(), -1);
+	groupMonomers.assign(tagGroups.size(), std::vector<uint32_t>());
+	for(size_t k = 0; k < ingredients.getMolecules().size(); k++)
+	{
+		const int32_t tag = ingredients.getMolecules()[k].getAttributeTag();
+		if(tag >= 0 && size_t(tag) < tagToGroup.size() && tagToGroup[tag] >= 0)
+		{
+			monomerGroup[k] = tagToGroup[tag];
+			groupMonomers[tagToGroup[tag]].push_back(k);
+		}
+	}
+	for(size_t g = 0; g < tagGroups.size(); g++)
+	{
+		if(tagGroups.size() > 1)
+			std::cout << "Analyzer_ChainWalking_RG2: group " << ColumnName("", g) << " with " << groupMonomers[g].size() << " monomers" << std::endl;
+		if(groupMonomers[g].empty())
+			std::cerr << "Analyzer_ChainWalking_RG2: no monomers in group " << g << ", its Rg2 is reported as 0" << std::endl;
+	}
+
+	maxDeviationPairSum = 0.0;
+
+	moleculeRg2Histogram.clear();
+	sumMoleculeRg2 = 0.0;
+	sumMoleculeRg2_x = 0.0;
+	sumMoleculeRg2_y = 0.0;
+	sumMoleculeRg2_z = 0.0;
+	nMoleculeValues = 0;
+
+	frameCounter = 0;
+
+	// the molecule index is built once and reused in every frame
+	if(perMolecule || unwrap)
+		moleculeIndex.build(ingredients.getMolecules());
+
+	if(perMolecule)
+	{
+		rg2Molecules.clear();
+		for(size_t m = 0; m < moleculeIndex.getNumMolecules(); m++)
+		{
+			const uint32_t* block = moleculeIndex.getMonomers(m);
+			for(size_t k = 0; k < moleculeIndex.getMoleculeSize(m); k++)
+			{
+				if(monomerGroup[block[k]] == 0)
+				{
+					rg2Molecules.push_back(m);
+					break;
+				}
+			}
+		}
+		std::cout << "Analyzer_ChainWalking_RG2: Rg2 of " << rg2Molecules.size() << " molecules, monomers with attribute tags " << ColumnName("", 0) << std::endl;
+	}
 
-	Rg_2_state.clear();
+	if(method==PAIR_SUM)
+		std::cout << "Analyzer_ChainWalking_RG2: Rg2 from the pair sum, validated against the moments" << std::endl;
 
-	looped_over_monomers = 0;
+	// the series file is written while the trajectory is analysed
+	std::string filenameGeneral=ingredients.getName();
+	filenameGeneral.erase (ingredients.getName().length()-4, ingredients.getName().length());
+
+	std::stringstream comment;
+	comment << "File produced by analyzer Analyzer_ChainWalking_RG2" << std::endl;
+	for(size_t g = 0; g < tagGroups.size(); g++)
+		comment << "Radius of Gyration " << ColumnName("Rg2", g) << " with " << groupMonomers[g].size() << " monomers" << std::endl;
+	comment << std::endl;
+	for(size_t g = 0; g < tagGroups.size(); g++)
+		comment << (g > 0 ? " " : "") << ColumnName("Rg2", g) << " " << ColumnName("lambda1", g) << " " << ColumnName("lambda2", g) << " " << ColumnName("lambda3", g);
+	seriesWriter.reset(new ColumnSeriesWriter(filenameGeneral + (binarySeries ? "_Rg2_all.bin" : "_Rg2_all.dat"), 4*tagGroups.size(), binarySeries, comment.str()));
+
+	// the reading thread shares the image flags and the copy of every frame with numThreads-1 helpers
+	gatherPool.resize(numThreads);
+
+	// frames are evaluated on the workers, at most two per thread are in flight
+	pipeline.reset();
+	if(frameParallel && numThreads > 1)
+	{
+		pipeline.reset(new OrderedFramePipeline<FrameData,FrameResult>(numThreads, 2*numThreads,
+			[this](const FrameData& frame, FrameResult& result){ AnalyseFrame(frame, result, 1); },
+			[this](const FrameResult& result){ AccumulateFrame(result); }));
+		std::cout << "Analyzer_ChainWalking_RG2: frames are evaluated on " << numThreads << " threads" << std::endl;
+	}
 
 	//set the initialized tag to true
 	initialized=true;
@@ -128,7 +366,17 @@ bool Analyzer_ChainWalking_RG2<IngredientsType>::execute()
 		throw std::runtime_error(errormessage.str());
 	}
 	
-	looped_over_monomers = 0; // reset the number of monomers at each frame
+	// the image flags follow every frame, also the skipped ones
+	if(unwrap)
+	{
+		if(!unwrappedCoordinates.isInitialized())
+			unwrappedCoordinates.initialize(ingredients, moleculeIndex);
+		else
+			unwrappedCoordinates.update(ingredients, moleculeIndex, gatherPool);
+	}
+
+	if((frameCounter++) % (skip+1) != 0)
+		return true;
 
 	//doing the calculation for Rg2 of the whole molecule in Ingredients
 
@@ -137,91 +385,17 @@ bool Analyzer_ChainWalking_RG2<IngredientsType>::execute()
 	{
 		std::cout << "SimpleAnalyzer_Rg2.execute() at MCS:" << ingredients.getMolecules().getAge() << std::endl;
 
-		int monomerCounter = 0;
-		
-		
-
-
-		// The radius of gyration is defined as
-		// Rg2 = 1/N * SUM_i=1 (r_i - r_COM)^2 = 1/N^2 * SUM_i=1 SUM_j=i (r_i - r_j)^2
-		// The components in the same manner
-
-		double Rg2 = 0.0;
-		double Rg2_x = 0.0;
-		double Rg2_y = 0.0;
-		double Rg2_z = 0.0;
-
-        
-
-		for (int k= 0; k < ingredients.getMolecules().size(); k++)
-		{ //if in group 1...
-			 //only loop over the monomers with attribute 1
-			if (ingredients.getMolecules()[k].getAttributeTag() == 1)
-			{
-			looped_over_monomers++;
-			
-			for (int l= k; l < ingredients.getMolecules().size(); l++)
-				{
-					if (ingredients.getMolecules()[l].getAttributeTag() == 1) //see if l th monomer is also type 1
-					
-					{
-
-					
-						Rg2_x += (ingredients.getMolecules()[k].getX()-ingredients.getMolecules()[l].getX())*(ingredients.getMolecules()[k].getX()-ingredients.getMolecules()[l].getX());
-						Rg2_y += (ingredients.getMolecules()[k].getY()-ingredients.getMolecules()[l].getY())*(ingredients.getMolecules()[k].getY()-ingredients.getMolecules()[l].getY());
-						Rg2_z += (ingredients.getMolecules()[k].getZ()-ingredients.getMolecules()[l].getZ())*(ingredients.getMolecules()[k].getZ()-ingredients.getMolecules()[l].getZ());
-					}
-
-				}
-			}
-			monomerCounter++;
-			
-		}
-		if(monomerCounter != ingredients.getMolecules().size())
+		// the frame is evaluated here or handed to the workers of the pipeline
+		if(pipeline)
 		{
-			throw std::runtime_error("invalid number of monomers in Rg2-calculation");
+			GatherPositions(pipeline->nextFrame());
+			pipeline->submit();
 		}
-	/*
-		Rg2_x /= 1.0*(ingredients.getMolecules().size()*ingredients.getMolecules().size());
-		Rg2_y /= 1.0*(ingredients.getMolecules().size()*ingredients.getMolecules().size());
-		Rg2_z /= 1.0*(ingredients.getMolecules().size()*ingredients.getMolecules().size());
-	
-	*/
-	
-		Rg2_x /= 1.0*(looped_over_monomers*looped_over_monomers);
-		Rg2_y /= 1.0*(looped_over_monomers*looped_over_monomers);
-		Rg2_z /= 1.0*(looped_over_monomers*looped_over_monomers);
-		
-		
-		
-		
-		Rg2 = Rg2_x+Rg2_y+Rg2_z;
-
-        
-        Rg_2_state.push_back(Rg2);
-
-		// add value to the average
-		sumRg2   += Rg2;
-		sumRg2_x += Rg2_x;
-		sumRg2_y += Rg2_y;
-		sumRg2_z += Rg2_z;
-
-		// increase the counter for average calculation
-		nValues++;
-
-
-		// calculate the bond length of the connected structure
-		for (int k= 0; k < ingredients.getMolecules().size(); k++)
+		else
 		{
-			for (int l = 0; l < ingredients.getMolecules().getNumLinks(k); l++)
-			{
-				if( k < ingredients.getMolecules().getNeighborIdx(k, l))
-				{
-				double BondLength = (ingredients.getMolecules()[k]-(ingredients.getMolecules()[ingredients.getMolecules().getNeighborIdx(k, l)])).getLength();
-				sumBondLength2 += BondLength*BondLength;
-				nValuesBondLength2++;
-				}
-			}
+			GatherPositions(currentFrame);
+			AnalyseFrame(currentFrame, currentResult, numThreads);
+			AccumulateFrame(currentResult);
 		}
 	}
 	
@@ -239,21 +413,95 @@ template<class IngredientsType>
 void Analyzer_ChainWalking_RG2<IngredientsType>::cleanup()
 {
     std::cout << "SimpleAnalyzer_Rg2.cleanup() " << std::endl;
-	// calculate the real average
-	sumRg2   = sumRg2  /(double (nValues));
-	sumRg2_x = sumRg2_x/(double (nValues));
-	sumRg2_y = sumRg2_y/(double (nValues));
-	sumRg2_z = sumRg2_z/(double (nValues));
-
-	// print results to stdout
-	std::cout<<"Average Rg2   : <Rg2  > = " << sumRg2   << std::endl;
-	std::cout<<"Average Rg2_x : <Rg2_x> = " << sumRg2_x << std::endl;
-	std::cout<<"Average Rg2_y : <Rg2_y> = " << sumRg2_y << std::endl;
-	std::cout<<"Average Rg2_z : <Rg2_z> = " << sumRg2_z << std::endl;
+	if(unwrappedCoordinates.getNumRepairs() > 0)
+		std::cout << unwrappedCoordinates.getNumRepairs() << " times a molecule was unwrapped again along its bonds (monomers moved half a box length between frames)" << std::endl;
+	// the frames still in the pipeline are accumulated in order
+	if(pipeline)
+	{
+		pipeline->finish();
+		pipeline.reset();
+	}
+
+	// all frames of the series are on disk after close()
+	if(seriesWriter)
+	{
+		seriesWriter->close();
+		std::cout << "Series of Rg2 and eigenvalues written to " << seriesWriter->getFilename() << std::endl;
+		seriesWriter.reset();
+	}
 
 	// calculate the real average of bond length
-	sumBondLength2   = sumBondLength2  /(double (nValuesBondLength2));
+	sumBondLength2   = bondSums.getMeanSquaredLength();
+
+	// construct a list
+	std::vector < std::vector<double> > tmpResultsRg2;
+
+	// we have 15 columns per group and 1 row
+	uint32_t columns = 15;
+	uint32_t rows = 1;
+
+	// we have columns
+	tmpResultsRg2.resize(columns*tagGroups.size());
+
+	// we have rows
+	for(size_t i = 0; i < tmpResultsRg2.size(); i++)
+		tmpResultsRg2[i].resize(rows);
+
+	std::stringstream columnNames;
+
+	for(size_t g = 0; g < tagGroups.size(); g++)
+	{
+		// calculate the real average
+		GroupValues& sums = groupSums[g];
+		sums.Rg2   = sums.Rg2  /(double (nValues));
+		sums.Rg2_x = sums.Rg2_x/(double (nValues));
+		sums.Rg2_y = sums.Rg2_y/(double (nValues));
+		sums.Rg2_z = sums.Rg2_z/(double (nValues));
+		for(int i = 0; i < 3; i++)
+			sums.lambda[i] = sums.lambda[i]/(double (nValues));
+		sums.asphericity = sums.asphericity/(double (nValues));
+		sums.acylindricity = sums.acylindricity/(double (nValues));
+		sums.shapeAnisotropy = sums.shapeAnisotropy/(double (nValues));
+
+		// print results to stdout
+		if(tagGroups.size() > 1)
+			std::cout<<"Group " << ColumnName("", g) << ":" << std::endl;
+		std::cout<<"Average Rg2   : <Rg2  > = " << sums.Rg2   << std::endl;
+		std::cout<<"Average Rg2_x : <Rg2_x> = " << sums.Rg2_x << std::endl;
+		std::cout<<"Average Rg2_y : <Rg2_y> = " << sums.Rg2_y << std::endl;
+		std::cout<<"Average Rg2_z : <Rg2_z> = " << sums.Rg2_z << std::endl;
+		std::cout<<"Average eigenvalues of the gyration tensor : <lambda1> <lambda2> <lambda3> = "
+				<< sums.lambda[0] << " " << sums.lambda[1] << " " << sums.lambda[2] << std::endl;
+		std::cout<<"Average asphericity, acylindricity, relative shape anisotropy : <b> <c> <kappa2> = "
+				<< sums.asphericity << " " << sums.acylindricity << " " << sums.shapeAnisotropy << std::endl;
+
+		// fill the list
+		std::vector < std::vector<double> >::iterator column = tmpResultsRg2.begin()+columns*g;
+		column[0][0]=sums.Rg2;
+		column[1][0]=sums.Rg2_x;
+		column[2][0]=sums.Rg2_y;
+		column[3][0]=sums.Rg2_z;
+		column[4][0]=sums.Rg2/sumBondLength2;
+		column[5][0]=sums.Rg2_x/sumBondLength2;
+		column[6][0]=sums.Rg2_y/sumBondLength2;
+		column[7][0]=sums.Rg2_z/sumBondLength2;
+		column[8][0]=sumBondLength2;
+		column[9][0]=sums.lambda[0];
+		column[10][0]=sums.lambda[1];
+		column[11][0]=sums.lambda[2];
+		column[12][0]=sums.asphericity;
+		column[13][0]=sums.acylindricity;
+		column[14][0]=sums.shapeAnisotropy;
+
+		const char* names[15] = {"<Rg2>", "<Rg2_x>", "<Rg2_y>", "<Rg2_z>", "<Rg2>/<b^2>", "<Rg2_x>/<b^2>", "<Rg2_y>/<b^2>", "<Rg2_z>/<b^2>",
+		                         "<b^2>", "<lambda1>", "<lambda2>", "<lambda3>", "<b>", "<c>", "<kappa2>"};
+		for(uint32_t i = 0; i < columns; i++)
+			columnNames << ((g > 0 || i > 0) ? " " : "") << ColumnName(names[i], g);
+	}
+
 	std::cout<<"Average (bond length)^2   : < b^2 > = " << sumBondLength2   << std::endl;
+	if(method==PAIR_SUM)
+		std::cout<<"Largest deviation of N^2 Rg2 components between pair sum and moments: " << maxDeviationPairSum << std::endl;
 	// print results into a file
 
 	// get the filename and path
@@ -261,77 +509,346 @@ void Analyzer_ChainWalking_RG2<IngredientsType>::cleanup()
 	// delete the .bfm in the name
 	filenameGeneral.erase (ingredients.getName().length()-4, ingredients.getName().length());
 
-	// construct a list
-	std::vector < std::vector<double> > tmpResultsRg2;
+	std::stringstream comment;
+	comment << "File produced by analyzer Analyzer_ChainWalking_RG2" << std::endl
+			<< "Radius of Gyration Rg2 with " << ingredients.getMolecules().size() << " monomers" << std::endl
+			<< "Average squared bond length <b^2>=" << sumBondLength2  << std::endl
+			<< std::endl
+			<< columnNames.str();
 
-	// we have 4 columns and 1 row
-	uint32_t columns = 9;
-	uint32_t rows = 1;
+	//new filename
+	std::string filenameRg2 = filenameGeneral + "_Rg2.dat";
 
-	// we have columns
-	tmpResultsRg2.resize(columns);
+	ResultFormattingTools::writeResultFile(filenameRg2, this->ingredients, tmpResultsRg2, comment.str());
 
-	// we have rows
-	for(int i = 0; i < columns; i++)
-		tmpResultsRg2[i].resize(rows);
+	WriteBondVectors(filenameGeneral);
+
+	if(perMolecule)
+		WriteMoleculeRg2(filenameGeneral);
+}
+
+/****************************************************************************
+ * GatherPositions
+ * copies the (unwrapped) coordinates of all monomers into the frame, blocks
+ * of monomers are distributed onto the threads of gatherPool
+ * *************************************************************************/
+template<class IngredientsType>
+void Analyzer_ChainWalking_RG2<IngredientsType>::GatherPositions(FrameData& frame)
+{
+	const size_t numMonomers = ingredients.getMolecules().size();
+	frame.x.resize(numMonomers);
+	frame.y.resize(numMonomers);
+	frame.z.resize(numMonomers);
+	const size_t numBlocks = (numMonomers + GATHER_BLOCK - 1) / GATHER_BLOCK;
+	gatherPool.parallelFor(numBlocks, [&](size_t block, uint32_t){
+		const size_t end = std::min(numMonomers, (block + 1) * GATHER_BLOCK);
+		for(size_t k = block * GATHER_BLOCK; k < end; k++)
+		{
+			const VectorInt3 pos = GetPosition(k);
+			frame.x[k] = pos.getX();
+			frame.y[k] = pos.getY();
+			frame.z[k] = pos.getZ();
+		}
+	});
+}
+
+/****************************************************************************
+ * AnalyseFrame
+ * Rg2, gyration tensor, bond vectors and molecule Rg2 of one frame. Only reads
+ * the frame and the tables built in initialize(), so frames can be evaluated
+ * concurrently.
+ * *************************************************************************/
+template<class IngredientsType>
+void Analyzer_ChainWalking_RG2<IngredientsType>::AnalyseFrame(const FrameData& frame, FrameResult& result, uint32_t moleculeThreads) const
+{
+	// The radius of gyration is defined as
+	// Rg2 = 1/N * SUM_i=1 (r_i - r_COM)^2 = 1/N^2 * SUM_i=1 SUM_j=i (r_i - r_j)^2
+	// The components in the same manner
 
-	// fill the list
+	// all six components of the gyration tensor of every group in the same pass
+	std::vector<GyrationMoments> moments;
+	CalcGyrationMoments(frame, moments);
 
-	tmpResultsRg2[0][0]=sumRg2;
-	tmpResultsRg2[1][0]=sumRg2_x;
-	tmpResultsRg2[2][0]=sumRg2_y;
-	tmpResultsRg2[3][0]=sumRg2_z;
-	tmpResultsRg2[4][0]=sumRg2/sumBondLength2;
-	tmpResultsRg2[5][0]=sumRg2_x/sumBondLength2;
-	tmpResultsRg2[6][0]=sumRg2_y/sumBondLength2;
-	tmpResultsRg2[7][0]=sumRg2_z/sumBondLength2;
-	tmpResultsRg2[8][0]=sumBondLength2;
+	result.groups.resize(tagGroups.size());
+	result.deviationPairSum = 0.0;
+	for(size_t g = 0; g < tagGroups.size(); g++)
+	{
+		GroupValues& values = result.groups[g];
+		int64_t N2Tensor[6];
+		moments[g].getN2Tensor(N2Tensor);
 
+		if(method==PAIR_SUM)
+		{
+			CalcRg2PairSum(frame, groupMonomers[g], values.Rg2_x, values.Rg2_y, values.Rg2_z);
+			result.deviationPairSum = std::max(result.deviationPairSum, std::fabs(values.Rg2_x-double(N2Tensor[0])));
+			result.deviationPairSum = std::max(result.deviationPairSum, std::fabs(values.Rg2_y-double(N2Tensor[1])));
+			result.deviationPairSum = std::max(result.deviationPairSum, std::fabs(values.Rg2_z-double(N2Tensor[2])));
+		}
+		else
+		{
+			values.Rg2_x = double(N2Tensor[0]);
+			values.Rg2_y = double(N2Tensor[1]);
+			values.Rg2_z = double(N2Tensor[2]);
+		}
 
-	// construct a list
-	std::vector < std::vector<double> > Rg_2_all;
+		// an empty group has Rg2 0
+		const double numMonomers = double(moments[g].getN());
+		if(numMonomers > 0.0)
+		{
+			values.Rg2_x /= (1.0*numMonomers*numMonomers);
+			values.Rg2_y /= (1.0*numMonomers*numMonomers);
+			values.Rg2_z /= (1.0*numMonomers*numMonomers);
+		}
 
-	// we have columns
-	Rg_2_all.resize(1);
+		values.Rg2 = values.Rg2_x+values.Rg2_y+values.Rg2_z;
 
-	// we have rows
-	//for(int i = 0; i < 1; i++)
-	Rg_2_all[0].resize(Rg_2_state.size());
-	//	Rg_2_all[i].resize(Rg_2_state.size());
+		// eigenvalues and shape descriptors of the gyration tensor
+		GyrationTensor tensor(moments[g]);
+		for(int i = 0; i < 3; i++)
+			values.lambda[i] = tensor.getEigenvalue(i);
+		values.asphericity = tensor.getAsphericity();
+		values.acylindricity = tensor.getAcylindricity();
+		values.shapeAnisotropy = tensor.getRelativeShapeAnisotropy();
+	}
+
+	// squared bond lengths and bond vectors of the connected structure from the bond list
+	result.bondSums.clear();
+	bondStatistics.addFrame(&frame.x[0], &frame.y[0], &frame.z[0], result.bondSums);
+
+	if(perMolecule)
+		CalcMoleculeRg2(frame, result, moleculeThreads);
+}
+
+/****************************************************************************
+ * AccumulateFrame
+ * adds one frame to the averages and the series. Called in frame order, so the
+ * floating point sums do not depend on the number of threads.
+ * *************************************************************************/
+template<class IngredientsType>
+void Analyzer_ChainWalking_RG2<IngredientsType>::AccumulateFrame(const FrameResult& result)
+{
+	maxDeviationPairSum = std::max(maxDeviationPairSum, result.deviationPairSum);
+
+	// add value to the average
+	for(size_t g = 0; g < tagGroups.size(); g++)
+	{
+		const GroupValues& values = result.groups[g];
+		GroupValues& sums = groupSums[g];
+		sums.Rg2   += values.Rg2;
+		sums.Rg2_x += values.Rg2_x;
+		sums.Rg2_y += values.Rg2_y;
+		sums.Rg2_z += values.Rg2_z;
+
+		for(int i = 0; i < 3; i++)
+			sums.lambda[i] += values.lambda[i];
+		sums.asphericity += values.asphericity;
+		sums.acylindricity += values.acylindricity;
+		sums.shapeAnisotropy += values.shapeAnisotropy;
+	}
 
-	//for(int i = 0; i < Rg_2_state.size(); i++)
-	Rg_2_all[0]=(Rg_2_state);
+	// one row of the series with Rg2 and the eigenvalues of every group
+	seriesRow.resize(4*tagGroups.size());
+	for(size_t g = 0; g < tagGroups.size(); g++)
+	{
+		seriesRow[4*g]   = result.groups[g].Rg2;
+		seriesRow[4*g+1] = result.groups[g].lambda[0];
+		seriesRow[4*g+2] = result.groups[g].lambda[1];
+		seriesRow[4*g+3] = result.groups[g].lambda[2];
+	}
+	seriesWriter->writeRow(&seriesRow[0]);
+
+	bondSums.merge(result.bondSums);
+
+	// increase the counter for average calculation
+	nValues++;
 
+	if(perMolecule)
+	{
+		for(size_t item = 0; item < rg2Molecules.size(); item++)
+		{
+			size_t bin = size_t(result.moleculeRg2[item]/moleculeRg2BinWidth);
+			if(bin >= moleculeRg2Histogram.size())
+				moleculeRg2Histogram.resize(bin+1, 0);
+			moleculeRg2Histogram[bin]++;
+
+			sumMoleculeRg2   += result.moleculeRg2[item];
+			sumMoleculeRg2_x += result.moleculeRg2Components[3*item];
+			sumMoleculeRg2_y += result.moleculeRg2Components[3*item+1];
+			sumMoleculeRg2_z += result.moleculeRg2Components[3*item+2];
+			nMoleculeValues++;
+		}
+	}
+}
+
+/****************************************************************************
+ * WriteBondVectors
+ * writes the occupancy of the 108 bond vectors to _Rg2_bondvectors.dat
+ * *************************************************************************/
+template<class IngredientsType>
+void Analyzer_ChainWalking_RG2<IngredientsType>::WriteBondVectors(const std::string& filenameGeneral)
+{
+	const double norm = (bondSums.getNumSamples() > 0) ? 1.0/double(bondSums.getNumSamples()) : 0.0;
 
+	std::vector < std::vector<double> > occupancy(5);
+	for(size_t id = 0; id < BondVectorStatistics::NUM_BOND_VECTORS; id++)
+	{
+		const VectorInt3 bond = BondVectorStatistics::getBondVector(id);
+		occupancy[0].push_back(bond.getX());
+		occupancy[1].push_back(bond.getY());
+		occupancy[2].push_back(bond.getZ());
+		occupancy[3].push_back(double(bondSums.getCount(id)));
+		occupancy[4].push_back(double(bondSums.getCount(id))*norm);
+	}
 
 	std::stringstream comment;
 	comment << "File produced by analyzer Analyzer_ChainWalking_RG2" << std::endl
-			<< "Radius of Gyration Rg2 with " << ingredients.getMolecules().size() << " monomers" << std::endl
-			<< "Average squared bond length <b^2>=" << sumBondLength2  << std::endl
+			<< "Occupancy of the bond vectors of " << bondStatistics.getNumBonds() << " bonds in " << nValues << " frames" << std::endl
+			<< "Average squared bond length <b^2>=" << bondSums.getMeanSquaredLength() << std::endl
+			<< "Bonds that are not in the bond vector set: " << bondSums.getNumOther() << std::endl
 			<< std::endl
-			<< "<Rg2> <Rg2_x> <Rg2_y> <Rg2_z> <Rg2>/<b^2> <Rg2_x>/<b^2> <Rg2_y>/<b^2> <Rg2_z>/<b^2> <b^2>";
+			<< "bx by bz count fraction";
 
-	std::stringstream comment2;
-	comment2 << "File produced by analyzer Analyzer_ChainWalking_RG2" << std::endl
-			<< "Radius of Gyration Rg2 with " << looped_over_monomers << " monomers" << std::endl
-			<< "Average squared bond length <b^2>=" << sumBondLength2  << std::endl
-			<< std::endl
-			<< "<Rg2>";
+	ResultFormattingTools::writeResultFile(filenameGeneral + "_Rg2_bondvectors.dat", this->ingredients, occupancy, comment.str());
+}
 
+/****************************************************************************
+ * CalcMoleculeRg2
+ * Rg2 of the monomers of the first tag group (-g, attribute 1 by default)
+ * of every molecule. Molecules are
+ * distributed onto moleculeThreads threads, every molecule writes its own
+ * result; the histogram and averages are updated in AccumulateFrame().
+ * *************************************************************************/
+template<class IngredientsType>
+void Analyzer_ChainWalking_RG2<IngredientsType>::CalcMoleculeRg2(const FrameData& frame, FrameResult& result, uint32_t moleculeThreads) const
+{
+	result.moleculeRg2.resize(rg2Molecules.size());
+	result.moleculeRg2Components.resize(3*rg2Molecules.size());
 
+	ParallelTasks::parallelFor(rg2Molecules.size(), moleculeThreads, [&](size_t item, uint32_t threadId){
+		const uint32_t m = rg2Molecules[item];
+		const uint32_t* block = moleculeIndex.getMonomers(m);
 
-    
-	//new filename
-	std::string filenameRg2 = filenameGeneral + "_Rg2.dat";
-    std::string filenameRg2_all = filenameGeneral + "_Rg2_all.dat";
+		GyrationMoments moments;
+		for(size_t k = 0; k < moleculeIndex.getMoleculeSize(m); k++)
+		{
+			const uint32_t i = block[k];
+			if(monomerGroup[i] == 0)
+			{
+				if(moments.getN() == 0)
+					moments.setOrigin(frame.x[i], frame.y[i], frame.z[i]);
+				moments.add(frame.x[i], frame.y[i], frame.z[i]);
+			}
+		}
 
-    
-    
+		int64_t N2Tensor[6];
+		moments.getN2Tensor(N2Tensor);
+		const double n2 = double(moments.getN())*double(moments.getN());
+		for(int a = 0; a < 3; a++)
+			result.moleculeRg2Components[3*item+a] = double(N2Tensor[a])/n2;
+		result.moleculeRg2[item] = result.moleculeRg2Components[3*item]+result.moleculeRg2Components[3*item+1]+result.moleculeRg2Components[3*item+2];
+	});
+}
 
-	ResultFormattingTools::writeResultFile(filenameRg2, this->ingredients, tmpResultsRg2, comment.str());
-    ResultFormattingTools::writeResultFile(filenameRg2_all, this->ingredients, Rg_2_all, comment2.str()); //fix output!
+/****************************************************************************
+ * WriteMoleculeRg2
+ * writes the distribution of the molecule Rg2 to _Rg2_molecules.dat with the
+ * ensemble averages over all molecules and frames in the comment
+ * *************************************************************************/
+template<class IngredientsType>
+void Analyzer_ChainWalking_RG2<IngredientsType>::WriteMoleculeRg2(const std::string& filenameGeneral)
+{
+	const double norm = (nMoleculeValues > 0) ? 1.0/double(nMoleculeValues) : 0.0;
+
+	std::cout<<"Ensemble average over molecules : <Rg2> <Rg2_x> <Rg2_y> <Rg2_z> = " << sumMoleculeRg2*norm << " "
+			<< sumMoleculeRg2_x*norm << " " << sumMoleculeRg2_y*norm << " " << sumMoleculeRg2_z*norm << std::endl;
+
+	std::vector < std::vector<double> > histogram(3);
+	for(size_t bin = 0; bin < moleculeRg2Histogram.size(); bin++)
+	{
+		histogram[0].push_back((bin+0.5)*moleculeRg2BinWidth);
+		histogram[1].push_back(double(moleculeRg2Histogram[bin]));
+		histogram[2].push_back(double(moleculeRg2Histogram[bin])*norm/moleculeRg2BinWidth);
+	}
+
+	std::stringstream comment;
+	comment << "File produced by analyzer Analyzer_ChainWalking_RG2" << std::endl
+			<< "Distribution of the Rg2 of " << rg2Molecules.size() << " molecules (monomers with attribute tags " << ColumnName("", 0) << ") in " << nValues << " frames" << std::endl
+			<< "Ensemble average <Rg2>=" << sumMoleculeRg2*norm << " <Rg2_x>=" << sumMoleculeRg2_x*norm
+			<< " <Rg2_y>=" << sumMoleculeRg2_y*norm << " <Rg2_z>=" << sumMoleculeRg2_z*norm << std::endl
+			<< std::endl
+			<< "Rg2 count probability_density";
+
+	ResultFormattingTools::writeResultFile(filenameGeneral + "_Rg2_molecules.dat", this->ingredients, histogram, comment.str());
 }
 
 
 
+/****************************************************************************
+ * CalcGyrationMoments
+ * N^2 G_ab = N SUM_k r_k,a r_k,b - SUM_k r_k,a SUM_k r_k,b, which is identical
+ * to the pair sum SUM_k SUM_l>k (r_k - r_l)_a (r_k - r_l)_b. One pass over all
+ * monomers adds each to the moments of its group; the coordinates are taken
+ * relative to the first monomer of the group (see GyrationMoments).
+ * *************************************************************************/
+template<class IngredientsType>
+void Analyzer_ChainWalking_RG2<IngredientsType>::CalcGyrationMoments(const FrameData& frame, std::vector<GyrationMoments>& moments) const
+{
+	moments.assign(tagGroups.size(), GyrationMoments());
+	for (size_t k = 0; k < monomerGroup.size(); k++)
+	{
+		const int32_t g = monomerGroup[k];
+		if(g < 0)
+			continue;
+		if(moments[g].getN() == 0)
+			moments[g].setOrigin(frame.x[k], frame.y[k], frame.z[k]);
+		moments[g].add(frame.x[k], frame.y[k], frame.z[k]);
+	}
+}
+
+/****************************************************************************
+ * CalcRg2PairSum
+ * original O(N^2) double sum over all pairs of the monomers of one group
+ * *************************************************************************/
+template<class IngredientsType>
+void Analyzer_ChainWalking_RG2<IngredientsType>::CalcRg2PairSum(const FrameData& frame, const std::vector<uint32_t>& monomers, double& N2Rg2_x, double& N2Rg2_y, double& N2Rg2_z) const
+{
+	N2Rg2_x = 0.0;
+	N2Rg2_y = 0.0;
+	N2Rg2_z = 0.0;
+
+	for (size_t n = 0; n < monomers.size(); n++)
+	{
+		const uint32_t k = monomers[n];
+
+		for (size_t m = n; m < monomers.size(); m++)
+		{
+			const uint32_t l = monomers[m];
+			N2Rg2_x += (frame.x[k]-frame.x[l])*(frame.x[k]-frame.x[l]);
+			N2Rg2_y += (frame.y[k]-frame.y[l])*(frame.y[k]-frame.y[l]);
+			N2Rg2_z += (frame.z[k]-frame.z[l])*(frame.z[k]-frame.z[l]);
+		}
+	}
+}
+
+/****************************************************************************
+ * ColumnName
+ * e.g. <Rg2>[1,2] for the group of the tags 1 and 2; with a single group the
+ * names are kept as they are
+ * *************************************************************************/
+template<class IngredientsType>
+std::string Analyzer_ChainWalking_RG2<IngredientsType>::ColumnName(const std::string& name, size_t g) const
+{
+	if(tagGroups.size() < 2 && !name.empty())
+		return name;
+
+	std::stringstream column;
+	column << name << "[";
+	for(size_t t = 0; t < tagGroups[g].size(); t++)
+		column << (t > 0 ? "," : "") << tagGroups[g][t];
+	column << "]";
+	return column.str();
+}
+
 #endif /*ANALYZER_CREATOR_SLOW_GROWTH_RG2_H*/
+
+
@@ -26,6 +26,10 @@ along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
 --------------------------------------------------------------------------------*/
 
 #include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <stdint.h>
 #include <stdlib.h> //for atoi
 #include <unistd.h> //for getopt
 
@@ -44,6 +48,24 @@ along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Analyzer_ChainWalking_RG2.h"
 
+// comma separated list of non-negative attribute tags, anything else is an error
+static std::vector<int32_t> parseTagGroup(const std::string& list)
+{
+	std::vector<int32_t> group;
+	std::stringstream tags(list);
+	std::string tag;
+	while(std::getline(tags, tag, ','))
+	{
+		char* end = 0;
+		const long value = strtol(tag.c_str(), &end, 10);
+		if(tag.empty() || *end != '\0' || value < 0 || value > std::numeric_limits<int32_t>::max())
+			throw std::runtime_error("invalid attribute tag '" + tag + "' in -g " + list);
+		group.push_back(int32_t(value));
+	}
+	if(group.empty())
+		throw std::runtime_error("empty list of attribute tags in -g");
+	return group;
+}
 
 int main(int argc, char* argv[])
 {
@@ -65,10 +87,27 @@ int main(int argc, char* argv[])
 
 	int skip = 0;
 
+	bool pairSum = false;
+
+	bool perMolecule = false;
+
+	uint32_t numThreads = ParallelTasks::getDefaultNumThreads();
+
+	double moleculeRg2BinWidth = 1.0;
+
+	bool unwrap = true;
+
+	bool binarySeries = false;
+
+	bool frameParallel = false;
+
+	// every -g adds a group of comma separated attribute tags, default is the group of tag 1
+	std::vector< std::vector<int32_t> > tagGroups;
+
 	int option_char(0);
 
 	//read in options by getopt
-	while ((option_char = getopt (argc, argv, "f:n:e:s:h"))  != EOF){
+	while ((option_char = getopt (argc, argv, "f:n:e:s:pmt:w:rbPg:h"))  != EOF){
 		switch (option_char)
 		{
 		case 'f':
@@ -78,14 +117,40 @@ int main(int argc, char* argv[])
 				  break;
 		case 's': skip = atol(optarg);
 				  break;
+		case 'p': pairSum = true;
+				  break;
+		case 'm': perMolecule = true;
+				  break;
+		case 't': numThreads = ParallelTasks::parseNumThreads(optarg);
+				  break;
+		case 'w': moleculeRg2BinWidth = atof(optarg);
+				  break;
+		case 'r': unwrap = false;
+				  break;
+		case 'b': binarySeries = true;
+				  break;
+		case 'P': frameParallel = true;
+				  break;
+		case 'g': tagGroups.push_back(parseTagGroup(optarg));
+				  break;
 		case 'h':
 		default:
-			std::cerr << "Usage: " << argv[0] << " [-f filename(=test.bfm)] [-e evaluation_time(=0)] [-s skipframe(=0)]\n";
+			std::cerr << "Usage: " << argv[0] << " [-f filename(=test.bfm)] [-e evaluation_time(=0)] [-s skipframe(=0)]\n"
+					  << "    [-p validate Rg2 with the O(N^2) pair sum]\n"
+					  << "    [-m Rg2 distribution of the single molecules, first -g group] [-t threads(=all cores)] [-w bin_width_molecule_Rg2(=1)]\n"
+					  << "    [-r use the raw coordinates, no unwrapping across periodic borders]\n"
+					  << "    [-b write the series of Rg2 and eigenvalues binary to _Rg2_all.bin instead of _Rg2_all.dat]\n"
+					  << "    [-P evaluate whole frames on the -t threads instead of the molecules of one frame;\n"
+					  << "        reading the frames stays in order, see ReadMe.txt for the attainable speed-up]\n"
+					  << "    [-g tags of a group, e.g. -g 1 -g 2,3 (=1); repeat for more groups, each gets its own columns]\n";
 
 			return 0;
 		}
 	}
 
+	if(tagGroups.empty())
+		tagGroups.push_back(std::vector<int32_t>(1, 1));
+
 	//seed the globally available random number generators
     RandomNumberGenerators randomNumbers;
     randomNumbers.seedAll();
@@ -95,7 +160,17 @@ int main(int argc, char* argv[])
     TaskManager taskmanager;
     taskmanager.addUpdater(new UpdaterReadBfmFile<Ing>(filename,myIngredients,UpdaterReadBfmFile<Ing>::READ_STEPWISE));
 
-    taskmanager.addAnalyzer(new Analyzer_ChainWalking_RG2<Ing>(myIngredients, evalulation_time), (skip+1));
+    Analyzer_ChainWalking_RG2<Ing>::Options options;
+    options.method = pairSum ? Analyzer_ChainWalking_RG2<Ing>::PAIR_SUM : Analyzer_ChainWalking_RG2<Ing>::MOMENTS;
+    options.perMolecule = perMolecule;
+    options.numThreads = numThreads;
+    options.moleculeRg2BinWidth = moleculeRg2BinWidth;
+    options.unwrap = unwrap;
+    options.skip = skip;
+    options.binarySeries = binarySeries;
+    options.frameParallel = frameParallel;
+    options.tagGroups = tagGroups;
+    taskmanager.addAnalyzer(new Analyzer_ChainWalking_RG2<Ing>(myIngredients, evalulation_time, options));
 
     taskmanager.initialize();
     taskmanager.run();
@@ -19,19 +19,122 @@
 #include <iostream>
 #include <fstream>
 #include <complex>
+#include <algorithm>
+#include <random>
+#include <memory>
+#include <type_traits>
+
+#include "VectorizedSinCos.h"
+#include "FastFourierTransform.h"
+#include "ParallelTasks.h"
+#include "MoleculeIndex.h"
+#include "PairDistanceHistogram.h"
+#include "ScatteringSeries.h"
+
+/*****************************************************************************/
+/**
+ * @class ChainWalkingScatteringSettings
+ * @brief modes and settings of Analyzer_ChainWalking_Scattering, shared by both kernel precisions
+ * */
+/*****************************************************************************/
+struct ChainWalkingScatteringSettings {
+  //! method used to calculate the scattering amplitude
+  enum ScatteringMode {RANDOM_DIRECTIONS=0, LATTICE_FFT=1, DEBYE=2, MOLECULE_FORM_FACTOR=3};
+
+  //! settings of the analysis, the defaults sample 10 random q directions per frame on one thread
+  struct Options {
+    ScatteringMode mode;
+    uint32_t numThreads;
+    //! q directions per frame and round of the adaptive sampling
+    uint32_t numDirections;
+    //! adaptive sampling until this relative error of |C_q|^2 is reached, 0 switches it off
+    double relativeErrorTolerance;
+    //! upper limit of q directions per frame for the adaptive sampling
+    uint32_t maxDirections;
+    //! partial structure factors of all attribute tag pairs
+    bool computePartials;
+    //! size of the Fibonacci direction set, 0 draws random directions
+    uint32_t directionSetSize;
+    bool rotateDirectionSet;
+    //! per frame time series _ScatteringSeries.bin
+    bool writeSeries;
+    //! seconds after which the series is handed to the disk even if its block is not full, 0 only writes full blocks
+    double seriesFlushInterval;
+
+    Options():mode(RANDOM_DIRECTIONS),numThreads(1),numDirections(10),relativeErrorTolerance(0.0),maxDirections(0),
+              computePartials(false),directionSetSize(0),rotateDirectionSet(true),writeSeries(false),seriesFlushInterval(60.0){}
+  };
+};
 
 /*****************************************************************************/
 /**
  * @class Analyzer_ChainWalking_Scattering
  * @brief  Analyzer class for monodispers dendrimers
- * @details Calculates formfactor via isotrop scattering simulation
+ * @details Calculates formfactor via isotrop scattering simulation.
+ * In mode RANDOM_DIRECTIONS the amplitude is sampled for numDirections random
+ * q directions per frame with the absolute values q_factor. The directions of
+ * a round are drawn on the calling thread from one generator, seeded from
+ * RandomNumberGenerators in initialize(), and dealt round robin to numThreads
+ * workers. The workers store |C_q|^2 of every direction, which is summed in
+ * direction order. The histograms of DEBYE and MOLECULE_FORM_FACTOR hold
+ * integer counts. Results of all modes are therefore reproducible for a
+ * given seed and do not depend on the number of threads.
+ * If relativeErrorTolerance is positive, further rounds of numDirections
+ * directions are drawn for the q bins whose relative standard error of
+ * |C_q|^2 within the frame is still above the tolerance, until maxDirections
+ * directions have been drawn in the frame. The time average weights the mean
+ * |C_q|^2 of every frame equally; the number of samples, which depends on the
+ * configuration, only enters the samples column.
+ * With directionSetSize>0 the random directions are replaced by a Fibonacci
+ * lattice of directionSetSize points on the half sphere (|C_q| = |C_-q|),
+ * set up in Init_qfactor(). If rotateDirectionSet is true, every round uses
+ * the set under a new uniformly random rotation, otherwise the same set is
+ * used in every frame and only one round is sampled.
+ * With computePartials the amplitudes C_a of all attribute tags a are summed
+ * separately from the same phases, and the partial structure factors
+ * S_ab = <Re(C_a conj(C_b))>/sqrt(N_a N_b) of all pairs a<=b are written as
+ * additional columns. The number of directions and the convergence refer to
+ * attribute 1 in all modes, so initialize() throws if the first configuration
+ * has no attribute 1 monomers.
+ * KernelFloatType selects the precision of the projections and of the phase
+ * kernel in this mode. With float the kernel has twice the SIMD width and
+ * accumulates with Kahan compensation. The positions are centred on their
+ * bounding box in every frame to keep the phases small, which does not change
+ * |C_q|. On the first frame the float kernel is compared with the double
+ * kernel and the maximum deviation of S(q) is reported.
+ * In mode LATTICE_FFT the amplitude is taken from a 3D FFT of the attribute 1
+ * density on the periodic lattice at all wave vectors
+ * 2 pi (n_x/L_x, n_y/L_y, n_z/L_z), and |C_q|^2 is binned onto the
+ * logarithmic q_factor grid. This costs O(L^3 log L) per frame independent of
+ * the number of monomers.
+ * In mode DEBYE the squared integer distances of all pairs of attribute 1
+ * monomers are histogrammed (distributed onto numThreads threads) and
+ * |C_q|^2 = N + 2 SUM_(r^2>0) n(r^2) sin(qr)/(qr) gives the
+ * orientational average of every frame. The histogram (PairDistanceHistogram)
+ * is exact below r=1024 and uses bins of width 1/64 in r beyond, so its
+ * memory grows linearly with the extent of the unwrapped coordinates.
+ * In mode MOLECULE_FORM_FACTOR the single chain form factor
+ * P(q) = <|C_q,m|^2/N_m>_m is averaged over all molecules m with attribute 1
+ * monomers, where C_q,m is the amplitude of the N_m attribute 1 monomers of m.
+ * Molecules are found by bond connectivity in initialize() (MoleculeIndex).
+ * Every chain is a task of its own: it is unwrapped with minimum image bonds
+ * into a contiguous coordinate block of the worker and its pair distances are
+ * histogrammed per number of scattering monomers, so the Debye sum of the
+ * frame is exact and independent of the number of threads.
+ * With writeSeries the sums of |C_q|^2, the number of samples and, with
+ * computePartials, the partial sums of every analysed frame are appended to
+ * the binary file _ScatteringSeries.bin (format in ScatteringSeries.h) by a
+ * background thread in blocks of 1 MiB, and at the latest seriesFlushInterval
+ * seconds after the last hand-over to the disk. The averaged scattering function,
+ * including the partial structure factors, can be rebuilt from any prefix of
+ * this file with ScatteringSeries_Average, also if the analysis was killed.
  * */
 /*****************************************************************************/
-template<class IngredientsType>
-class Analyzer_ChainWalking_Scattering: public AbstractAnalyzer {
+template<class IngredientsType, class KernelFloatType=double>
+class Analyzer_ChainWalking_Scattering: public AbstractAnalyzer, public ChainWalkingScatteringSettings {
 public:
   //constructor
-  Analyzer_ChainWalking_Scattering(const IngredientsType&, long evalulation_time_, int32_t relaxtime_=0, double binWidth_=1);
+  Analyzer_ChainWalking_Scattering(const IngredientsType&, long evalulation_time_, int32_t relaxtime_=0, double binWidth_=1, const Options& options=Options());
   
   //destructor
   ~Analyzer_ChainWalking_Scattering(){}
@@ -61,21 +164,137 @@ private:
   int32_t relaxtime;
   double binWidth;
   uint32_t num_of_q;
+  ScatteringMode mode;
+  uint32_t numThreads;
+  uint32_t numDirections;
+  double relativeErrorTolerance;
+  uint32_t maxDirections;
+  bool computePartials;
+  uint32_t directionSetSize;
+  bool rotateDirectionSet;
+  bool writeSeries;
+  double seriesFlushInterval;
+  
+  // true after the float kernel has been compared with the double kernel
+  bool precisionChecked;
   
-  // vector for averaged squared absolute value of scattering amplitude
+  // sum over the frames of the mean squared absolute value of the scattering amplitude of every frame,
+  // every frame has the weight 1 also if the adaptive sampling drew more directions in it
   std::vector<double> averagedSquaredAbsC_q;
   
-  // vector for averaged squared absolute value of scattering amplitude
+  // number of frames with samples and the total number of samples of every q bin
+  std::vector<double> averagedSquaredAbsC_q_frames;
   std::vector<double> averagedSquaredAbsC_q_elements;
 
   // vector for q-vector absolute values
   std::vector<double> q_factor;
   
+  // geometric mean of neighbouring q_factor, borders of the bins in LATTICE_FFT mode
+  std::vector<double> q_binEdges;
+  
+  // density of the scattering monomers on the lattice and its Fourier transform
+  std::vector<double_complex> densityGrid;
+  
+  // transform of the box in LATTICE_FFT mode, set up once by initialize()
+  FastFourierTransform3D latticeTransform;
+  
+  // thread local histograms of the squared pair distances in DEBYE mode
+  std::vector<PairDistanceHistogram> pairDistanceHistograms;
+  
+  // attribute tags with an own amplitude: all tags for partials, otherwise only tag 1
+  std::vector<int32_t> scatteringTags;
+  
+  // index into scatteringTags for every attribute tag, -1 for tags that do not scatter
+  std::vector<int32_t> tagToGroup;
+  
+  // index of attribute tag 1 in scatteringTags, S(q) and its normalisation refer to this group
+  int32_t polymerGroup;
+  
+  // structure of arrays with the positions of the scattering monomers sorted by tag,
+  // monomers of scatteringTags[g] are stored at [tagOffsets[g],tagOffsets[g+1])
+  std::vector<double> posX;
+  std::vector<double> posY;
+  std::vector<double> posZ;
+  std::vector<size_t> tagOffsets;
+  
+  // sums over the frames of the frame means of Re(C_a conj(C_b)) for all pairs a<=b of scatteringTags
+  std::vector< std::vector<double> > averagedPartialC_q;
+  
+  // state of one thread in mode RANDOM_DIRECTIONS
+  struct DirectionWorker {
+    // projection r*q of every scattering monomer onto the current unit q-vector
+    std::vector<KernelFloatType> projection;
+    // real and imaginary part of C_q for every tag
+    std::vector<double> tagCos;
+    std::vector<double> tagSin;
+  };
+  std::vector<DirectionWorker> directionWorkers;
+  
+  // |C_q|^2 and Re(C_a conj(C_b)) of every direction of the current round and every
+  // active bin, [direction*activeBins.size()+bin] and [(direction*activeBins.size()+bin)*numPairs+pair]
+  std::vector<double> directionSquaredAbsC_q;
+  std::vector<double> directionPartialC_q;
+  
+  // sums of |C_q|^2, |C_q|^4 and number of samples of the current frame,
+  // filled by the calculation of every mode and added to the averages in execute()
+  std::vector<double> frameSquaredAbsC_q;
+  std::vector<double> frameSquaredAbsC_q_squares;
+  std::vector<double> frameSquaredAbsC_q_elements;
+  std::vector< std::vector<double> > framePartialC_q;
+  
+  // q bins that are sampled in the next round of directions
+  std::vector<uint32_t> activeBins;
+  
+  // quasi-random set of unit q-vectors and its rotated copy used in the current round
+  std::vector<VectorDouble3> directionSet;
+  std::vector<VectorDouble3> roundDirections;
+  
+  // random number streams for the random q directions and the rotations of directionSet
+  std::mt19937 directionGenerator;
+  std::mt19937 rotationGenerator;
+  
+  // molecules by bond connectivity, set up in initialize() for MOLECULE_FORM_FACTOR
+  MoleculeIndex moleculeIndex;
+  
+  // molecules with attribute 1 monomers and the index of their number of
+  // attribute 1 monomers in formFactorSizes
+  std::vector<uint32_t> formFactorMolecules;
+  std::vector<uint32_t> formFactorSizeClass;
+  std::vector<uint32_t> formFactorSizes;
+  
+  // state of one thread in mode MOLECULE_FORM_FACTOR
+  struct MoleculeWorker {
+    // unwrapped positions of the current molecule, compacted to its attribute 1 monomers
+    std::vector<int32_t> x;
+    std::vector<int32_t> y;
+    std::vector<int32_t> z;
+    // squared pair distance histograms for every entry of formFactorSizes
+    std::vector<PairDistanceHistogram> histograms;
+  };
+  std::vector<MoleculeWorker> moleculeWorkers;
+  
+  // writer of the per frame time series, only open with writeSeries
+  std::unique_ptr<BackgroundFileWriter> seriesWriter;
+  
   // private functions
+  void InitScatteringTags();
+  void CollectScatteringPositions();
+  void ComparePrecision();
   void CalcScatteringAmplitude();
+  void SampleDirections(uint32_t numDirectionsInRound);
+  bool IsConverged(uint32_t bin) const;
+  void CalcScatteringAmplitudeFFT();
+  void CalcScatteringAmplitudeDebye();
+  void InitMolecules();
+  void CalcMoleculeFormFactor();
+  int32_t GetQBin(double qfactor) const;
+  
+  size_t PairIndex(size_t a, size_t b) const;
   void CalcBinning();
   void Init_qfactor();
-  VectorDouble3 GetRandQVector();
+  VectorDouble3 GetRandQVector(std::mt19937& generator);
+  void InitDirectionSet();
+  void RotateDirectionSet();
   
 
   long evalulation_time;
@@ -83,33 +302,119 @@ private:
 
 /******************************************************************************/
 /**
- * @fn void Analyzer_ChainWalking_Scattering<IngredientsType>::Analyzer_ChainWalking_Scattering()
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::Analyzer_ChainWalking_Scattering()
  * @brief Constructor: declaration of intern molecule properties
  */
-template<class IngredientsType>
-Analyzer_ChainWalking_Scattering<IngredientsType>::Analyzer_ChainWalking_Scattering(
-  const IngredientsType& ingredients_, long evalulation_time_,  int32_t relaxtime_, double binWidth_):
+template<class IngredientsType, class KernelFloatType>
+Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::Analyzer_ChainWalking_Scattering(
+  const IngredientsType& ingredients_, long evalulation_time_,  int32_t relaxtime_, double binWidth_, const Options& options):
   ingredients(ingredients_), 
   currentTimestep(0),
   relaxtime(relaxtime_),
   binWidth(binWidth_),
   num_of_q(200),
+  mode(options.mode),
+  numThreads(options.numThreads > 0 ? options.numThreads : 1),
+  numDirections(options.directionSetSize > 0 ? options.directionSetSize : options.numDirections),
+  relativeErrorTolerance(options.relativeErrorTolerance),
+  maxDirections(std::max(numDirections,options.maxDirections)),
+  computePartials(options.computePartials),
+  directionSetSize(options.directionSetSize),
+  rotateDirectionSet(options.rotateDirectionSet),
+  writeSeries(options.writeSeries),
+  seriesFlushInterval(options.seriesFlushInterval),
+  precisionChecked(std::is_same<KernelFloatType,double>::value),
   q_factor(),
   averagedSquaredAbsC_q(num_of_q,0.0),
+  averagedSquaredAbsC_q_frames(num_of_q,0.0),
   averagedSquaredAbsC_q_elements(num_of_q,0.0),
+  polymerGroup(-1),
   evalulation_time(evalulation_time_)
 {}
   
 /******************************************************************************/
 /**
- * @fn void Analyzer_ChainWalking_Scattering<IngredientsType>::initialize()
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::initialize()
  * @brief preparation of output files and memory allocation
  */
-template<class IngredientsType>
-void Analyzer_ChainWalking_Scattering<IngredientsType>::initialize(){
+template<class IngredientsType, class KernelFloatType>
+void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::initialize(){
   std::cout << "\nAnalyzer_ChainWalking_Scattering initialise\n";
   
   Init_qfactor();
+  if(computePartials && mode!=RANDOM_DIRECTIONS)
+    throw std::runtime_error("Analyzer_ChainWalking_Scattering: partial structure factors need mode RANDOM_DIRECTIONS");
+  InitScatteringTags();
+  if(mode==MOLECULE_FORM_FACTOR)
+    InitMolecules();
+  if(mode==LATTICE_FFT)
+    latticeTransform=FastFourierTransform3D(ingredients.getBoxX(),ingredients.getBoxY(),ingredients.getBoxZ());
+
+  if(mode==LATTICE_FFT)
+    std::cout << "scattering amplitude from FFT of the " << ingredients.getBoxX() << "x" << ingredients.getBoxY() << "x" << ingredients.getBoxZ() << " lattice" << std::endl;
+  else if(mode==DEBYE)
+    std::cout << "scattering function from pair distance histogram on " << numThreads << " threads" << std::endl;
+  else if(mode==MOLECULE_FORM_FACTOR)
+    std::cout << "form factor of " << formFactorMolecules.size() << " molecules from pair distance histograms on "
+    << numThreads << " threads" << std::endl;
+  else
+    std::cout << "phase kernel uses instruction set " << CpuFeatures::getInstructionSetName()
+    << " in " << (std::is_same<KernelFloatType,float>::value ? "single" : "double") << " precision"
+    << ", " << numDirections << " q directions per frame on " << numThreads << " threads" << std::endl;
+  if(mode==RANDOM_DIRECTIONS && directionSetSize>0)
+    std::cout << "q directions from a Fibonacci set of " << directionSetSize << " points"
+    << (rotateDirectionSet ? " with random rotation" : "") << std::endl;
+  if(mode==RANDOM_DIRECTIONS && relativeErrorTolerance>0.0)
+    std::cout << "adaptive sampling up to " << maxDirections << " q directions per frame for relative error "
+    << relativeErrorTolerance << std::endl;
+
+  // deterministic streams derived from the global generator, independent of numThreads
+  directionGenerator.seed(rng.r250_rand32());
+  rotationGenerator.seed(rng.r250_rand32());
+  directionWorkers.resize(numThreads);
+  for(uint32_t t=0;t<numThreads;t++){
+    directionWorkers[t].tagCos.resize(scatteringTags.size());
+    directionWorkers[t].tagSin.resize(scatteringTags.size());
+  }
+
+  if(writeSeries){
+    std::string filenameSeries(ingredients.getName());
+    filenameSeries.erase(filenameSeries.length()-4,filenameSeries.length());
+    filenameSeries+="_ScatteringSeries.bin";
+
+    // S(q) is normalised with the number of attribute 1 monomers, the form factor per molecule
+    double normalization(0.0);
+    for(uint32_t k=0;k<ingredients.getMolecules().size();k++)
+      if(ingredients.getMolecules()[k].getAttributeTag()==1)
+        normalization+=1.0;
+    if(mode==MOLECULE_FORM_FACTOR)
+      normalization=1.0;
+
+    std::vector<double> q(q_factor.size());
+    for(uint32_t j=0;j<q_factor.size();j++)
+      q[j]=q_factor.at(j)*((2*M_PI)/ingredients.getBoxX());
+
+    // partial structure factors S_ab are normalised with sqrt(N_a N_b)
+    std::vector<ScatteringSeries::PartialPair> partials;
+    if(computePartials){
+      std::vector<double> numPerTag(scatteringTags.size(),0.0);
+      for(uint32_t k=0;k<ingredients.getMolecules().size();k++)
+        numPerTag[tagToGroup[ingredients.getMolecules()[k].getAttributeTag()]]+=1.0;
+      for(size_t a=0;a<scatteringTags.size();a++)
+        for(size_t b=a;b<scatteringTags.size();b++){
+          ScatteringSeries::PartialPair pair;
+          pair.tagA=scatteringTags[a];
+          pair.tagB=scatteringTags[b];
+          pair.normalization=std::sqrt(numPerTag[a]*numPerTag[b]);
+          partials.push_back(pair);
+        }
+    }
+
+    seriesWriter.reset(new BackgroundFileWriter(filenameSeries,size_t(1)<<20,8,seriesFlushInterval));
+    ScatteringSeries::writeHeader(*seriesWriter,q,normalization,
+      (mode==MOLECULE_FORM_FACTOR) ? ScatteringSeries::FORM_FACTOR : ScatteringSeries::STRUCTURE_FACTOR, partials);
+    std::cout << "per frame scattering sums are written to " << filenameSeries << std::endl;
+  }
 
   std::cout << "Analyzer_ChainWalking_Scattering initialised successfully\n\n";
   //first config is written in by BFM file reader in initialise, so execute has to be called in this step the first time too
@@ -118,17 +423,41 @@ void Analyzer_ChainWalking_Scattering<IngredientsType>::initialize(){
 
 /******************************************************************************/
 /**
- * @fn void Analyzer_ChainWalking_Scattering<IngredientsType>::execute()
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::execute()
  * @brief Calculates and writes out the Rg^2 and Ree^2 
  */
-template<class IngredientsType>
-bool Analyzer_ChainWalking_Scattering<IngredientsType>::execute(){
+template<class IngredientsType, class KernelFloatType>
+bool Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::execute(){
   currentTimestep++;
   std::cout << "Analyzer_ChainWalking_Scattering starts to execute timestep nr "<<currentTimestep <<"\n";
   
   if(ingredients.getMolecules().getAge() > evalulation_time)
   {
-    CalcScatteringAmplitude();
+    frameSquaredAbsC_q.assign(num_of_q,0.0);
+    frameSquaredAbsC_q_elements.assign(num_of_q,0.0);
+
+    if(mode==LATTICE_FFT)
+      CalcScatteringAmplitudeFFT();
+    else if(mode==DEBYE)
+      CalcScatteringAmplitudeDebye();
+    else if(mode==MOLECULE_FORM_FACTOR)
+      CalcMoleculeFormFactor();
+    else
+      CalcScatteringAmplitude();
+
+    // the mean of every frame enters with the same weight, the number of samples differs between
+    // frames with adaptive sampling and depends on the configuration
+    for(uint32_t j=0;j<num_of_q;j++){
+      if(frameSquaredAbsC_q_elements[j]==0.0)
+        continue;
+      averagedSquaredAbsC_q.at(j)+=frameSquaredAbsC_q[j]/frameSquaredAbsC_q_elements[j];
+      averagedSquaredAbsC_q_frames.at(j)+=1.0;
+      averagedSquaredAbsC_q_elements.at(j)+=frameSquaredAbsC_q_elements[j];
+      for(size_t p=0;p<averagedPartialC_q.size();p++)
+        averagedPartialC_q[p].at(j)+=framePartialC_q[p][j]/frameSquaredAbsC_q_elements[j];
+    }
+    if(seriesWriter)
+      ScatteringSeries::writeFrame(*seriesWriter,ingredients.getMolecules().getAge(),frameSquaredAbsC_q,frameSquaredAbsC_q_elements,framePartialC_q);
   }
   
 
@@ -140,13 +469,17 @@ bool Analyzer_ChainWalking_Scattering<IngredientsType>::execute(){
 
 /******************************************************************************/
 /**
- * @fn void Analyzer_ChainWalking_Scattering<IngredientsType>::cleanup()
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::cleanup()
  * @brief Write out results
  */
-template<class IngredientsType>
-void Analyzer_ChainWalking_Scattering<IngredientsType>::cleanup(){
+template<class IngredientsType, class KernelFloatType>
+void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::cleanup(){
   
   std::cout << "Analyzer_ChainWalking_Scattering starts clean up after timestep "<<currentTimestep <<"\n";
+  if(seriesWriter){
+    seriesWriter->close();
+    std::cout << "time series closed in " << seriesWriter->getFilename() << std::endl;
+  }
   std::ofstream FormFactorFile;
   
   if(currentTimestep > relaxtime){
@@ -160,20 +493,39 @@ void Analyzer_ChainWalking_Scattering<IngredientsType>::cleanup(){
 	std::string filename_ScatteringFct = filenameGeneral + "_ScatteringFct.dat";
 
   u_int32_t numScatteringObj=0;
+  std::vector<double> numPerTag(scatteringTags.size(),0.0);
 
   for(uint32_t k=0;k<ingredients.getMolecules().size();k++){
     if((ingredients.getMolecules()[k].getAttributeTag()==1))
      numScatteringObj++;
+    if(computePartials)
+     numPerTag[tagToGroup[ingredients.getMolecules()[k].getAttributeTag()]]+=1.0;
   }
 
     FormFactorFile.open (filename_ScatteringFct.c_str(),std::ios::out);
+    // the form factor is already normalised per molecule
+    const double normalization((mode==MOLECULE_FORM_FACTOR) ? 1.0 : 1.0*numScatteringObj);
     FormFactorFile << "# Molecular Scattering Function\n"
-    << "# q    S(q)   samples"<< std::endl;
+    << ((mode==MOLECULE_FORM_FACTOR) ? "# q    P(q)   samples" : "# q    S(q)   samples");
+    if(computePartials){
+      for(size_t a=0;a<scatteringTags.size();a++)
+        for(size_t b=a;b<scatteringTags.size();b++)
+          FormFactorFile << "   S_" << scatteringTags[a] << "_" << scatteringTags[b] << "(q)";
+    }
+    FormFactorFile << std::endl;
     for (uint32_t i=0;i<q_factor.size();i++){
+      // bins without any lattice wave vector (LATTICE_FFT at small q) are skipped
+      if(averagedSquaredAbsC_q_frames.at(i)==0.0)
+        continue;
       FormFactorFile << q_factor.at(i)*((2*M_PI)/ingredients.getBoxX()) <<" "
-      << averagedSquaredAbsC_q.at(i)/(averagedSquaredAbsC_q_elements.at(i)*(1.0*numScatteringObj)) << " "
-      << averagedSquaredAbsC_q_elements.at(i)
-	  << std::endl;
+      << averagedSquaredAbsC_q.at(i)/(averagedSquaredAbsC_q_frames.at(i)*normalization) << " "
+      << averagedSquaredAbsC_q_elements.at(i);
+      if(computePartials){
+        for(size_t a=0;a<scatteringTags.size();a++)
+          for(size_t b=a;b<scatteringTags.size();b++)
+            FormFactorFile << " " << averagedPartialC_q[PairIndex(a,b)].at(i)/(averagedSquaredAbsC_q_frames.at(i)*std::sqrt(numPerTag[a]*numPerTag[b]));
+      }
+      FormFactorFile << std::endl;
     }
   }else{
     std::cout<<"****   **** No output file written!! ****   ****\n****   **** Not enought configs in input file!! ****   ****\n";
@@ -184,11 +536,11 @@ void Analyzer_ChainWalking_Scattering<IngredientsType>::cleanup(){
 
 /******************************************************************************/
 /**
- * @fn void Analyzer_ChainWalking_Scattering<IngredientsType>::Init_qfactor( void )
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::Init_qfactor( void )
  * @brief initialise set of q vectors in multiplicative manner
  */
-template<class IngredientsType>
-void Analyzer_ChainWalking_Scattering<IngredientsType>::Init_qfactor(){
+template<class IngredientsType, class KernelFloatType>
+void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::Init_qfactor(){
   double k(std::exp(std::log((10.0*ingredients.getBoxX()))*1.0/(num_of_q)));
   double x(0.1);
   std::cout << "multiplicator for abs(q) k = " << k << std::endl;
@@ -199,77 +551,608 @@ void Analyzer_ChainWalking_Scattering<IngredientsType>::Init_qfactor(){
   }
   if((q_factor.at(num_of_q-1) - (double)(4*ingredients.getBoxX())) > 0.00001)
     throw std::runtime_error("wrong q_vector array!");
+
+  q_binEdges.clear();
+  for(uint32_t i=0; i+1<num_of_q; i++)
+    q_binEdges.push_back(std::sqrt(q_factor.at(i)*q_factor.at(i+1)));
+
+  InitDirectionSet();
+}
+
+/******************************************************************************/
+/**
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::InitDirectionSet( void )
+ * @brief Fibonacci lattice of directionSetSize unit vectors on the half sphere z>0
+ * @details The points have equal area on the half sphere and the golden angle
+ * between successive azimuths, which gives a low discrepancy direction set.
+ */
+template<class IngredientsType, class KernelFloatType>
+void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::InitDirectionSet(){
+  directionSet.clear();
+  const double goldenAngle(M_PI*(3.0-std::sqrt(5.0)));
+  for(uint32_t i=0; i<directionSetSize; i++){
+    double z(1.0-(i+0.5)/directionSetSize);
+    double r(std::sqrt(1.0-z*z));
+    double phi(goldenAngle*i);
+    directionSet.push_back(VectorDouble3(r*std::cos(phi),r*std::sin(phi),z));
+  }
+  roundDirections=directionSet;
+}
+
+/******************************************************************************/
+/**
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::RotateDirectionSet( void )
+ * @brief copies directionSet rotated by a uniformly random rotation into roundDirections
+ * @details The rotation is built from a random unit quaternion (Shoemake's method).
+ */
+template<class IngredientsType, class KernelFloatType>
+void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::RotateDirectionSet(){
+  std::uniform_real_distribution<double> uniform(0.0,1.0);
+  double u1(uniform(rotationGenerator));
+  double u2(uniform(rotationGenerator));
+  double u3(uniform(rotationGenerator));
+  double a(std::sqrt(1.0-u1)*std::sin(2.0*M_PI*u2));
+  double b(std::sqrt(1.0-u1)*std::cos(2.0*M_PI*u2));
+  double c(std::sqrt(u1)*std::sin(2.0*M_PI*u3));
+  double w(std::sqrt(u1)*std::cos(2.0*M_PI*u3));
+
+  VectorDouble3 row0(1.0-2.0*(b*b+c*c), 2.0*(a*b-c*w), 2.0*(a*c+b*w));
+  VectorDouble3 row1(2.0*(a*b+c*w), 1.0-2.0*(a*a+c*c), 2.0*(b*c-a*w));
+  VectorDouble3 row2(2.0*(a*c-b*w), 2.0*(b*c+a*w), 1.0-2.0*(a*a+b*b));
+  for(size_t i=0; i<directionSet.size(); i++)
+    roundDirections[i]=VectorDouble3(row0*directionSet[i],row1*directionSet[i],row2*directionSet[i]);
+}
+
+/******************************************************************************/
+/**
+ * @fn int32_t Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::GetQBin( double qfactor ) const
+ * @brief index of the logarithmic bin around q_factor containing qfactor
+ * @return bin index or -1 if qfactor is outside of the q_factor range
+ */
+template<class IngredientsType, class KernelFloatType>
+int32_t Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::GetQBin(double qfactor) const{
+  // bins are symmetric around q_factor in log scale
+  const double halfStep(std::sqrt(q_factor.at(1)/q_factor.at(0)));
+  if(qfactor < q_factor.front()/halfStep || qfactor >= q_factor.back()*halfStep)
+    return -1;
+  return int32_t(std::upper_bound(q_binEdges.begin(),q_binEdges.end(),qfactor)-q_binEdges.begin());
+}
+
+/******************************************************************************/
+/**
+ * @fn size_t Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::PairIndex( size_t a, size_t b ) const
+ * @brief index of the tag pair a<=b in averagedPartialC_q, the pairs are ordered by a, then by b
+ */
+template<class IngredientsType, class KernelFloatType>
+size_t Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::PairIndex(size_t a, size_t b) const{
+  return a*scatteringTags.size()-a*(a-1)/2+(b-a);
+}
+
+/******************************************************************************/
+/**
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::InitScatteringTags( void )
+ * @brief sets up the attribute tags with an own amplitude from the first configuration
+ */
+template<class IngredientsType, class KernelFloatType>
+void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::InitScatteringTags(){
+	scatteringTags.clear();
+	if(computePartials){
+		for(uint32_t k=0;k<ingredients.getMolecules().size();k++){
+			int32_t tag(ingredients.getMolecules()[k].getAttributeTag());
+			if(tag<0)
+				throw std::runtime_error("Analyzer_ChainWalking_Scattering: negative attribute tags are not supported for partials");
+			if(std::find(scatteringTags.begin(),scatteringTags.end(),tag)==scatteringTags.end())
+				scatteringTags.push_back(tag);
+		}
+		std::sort(scatteringTags.begin(),scatteringTags.end());
+	}else{
+		scatteringTags.push_back(1);
+	}
+
+	tagToGroup.assign(scatteringTags.back()+1,-1);
+	for(size_t g=0;g<scatteringTags.size();g++)
+		tagToGroup[scatteringTags[g]]=g;
+	polymerGroup=(tagToGroup.size()>1) ? tagToGroup[1] : -1;
+
+	// S(q) is normalised with the number of attribute 1 monomers, without them every column would be 0/0
+	bool hasPolymer(false);
+	for(uint32_t k=0;k<ingredients.getMolecules().size() && !hasPolymer;k++)
+		hasPolymer=(ingredients.getMolecules()[k].getAttributeTag()==1);
+	if(polymerGroup<0 || !hasPolymer)
+		throw std::runtime_error("Analyzer_ChainWalking_Scattering: no monomers with attribute tag 1 in the first configuration, S(q) is normalised with their number");
+
+	const size_t numPairs(computePartials ? scatteringTags.size()*(scatteringTags.size()+1)/2 : 0);
+	averagedPartialC_q.assign(numPairs,std::vector<double>(num_of_q,0.0));
+	if(computePartials){
+		std::cout << "partial structure factors for attribute tags";
+		for(size_t g=0;g<scatteringTags.size();g++)
+			std::cout << " " << scatteringTags[g];
+		std::cout << std::endl;
+	}
+}
+
+/******************************************************************************/
+/**
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::CollectScatteringPositions( void )
+ * @brief copies the positions of all scattering monomers into posX, posY, posZ, sorted by tag
+ */
+template<class IngredientsType, class KernelFloatType>
+void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::CollectScatteringPositions(){
+	const int32_t numTags(tagToGroup.size());
+
+	// count the monomers per tag, monomers with other attributes have scattering factor 0
+	tagOffsets.assign(scatteringTags.size()+1,0);
+	for(uint32_t k=0;k<ingredients.getMolecules().size();k++){
+		int32_t tag(ingredients.getMolecules()[k].getAttributeTag());
+		if(tag>=0 && tag<numTags && tagToGroup[tag]>=0)
+			tagOffsets[tagToGroup[tag]+1]++;
+		else if(computePartials)
+			throw std::runtime_error("Analyzer_ChainWalking_Scattering: attribute tag missing in the first configuration");
+	}
+	for(size_t g=0;g<scatteringTags.size();g++)
+		tagOffsets[g+1]+=tagOffsets[g];
+
+	posX.resize(tagOffsets.back());
+	posY.resize(tagOffsets.back());
+	posZ.resize(tagOffsets.back());
+	std::vector<size_t> next(tagOffsets.begin(),tagOffsets.end()-1);
+	for(uint32_t k=0;k<ingredients.getMolecules().size();k++){
+		int32_t tag(ingredients.getMolecules()[k].getAttributeTag());
+		if(tag>=0 && tag<numTags && tagToGroup[tag]>=0){
+			size_t idx(next[tagToGroup[tag]]++);
+			posX[idx]=ingredients.getMolecules()[k].getX();
+			posY[idx]=ingredients.getMolecules()[k].getY();
+			posZ[idx]=ingredients.getMolecules()[k].getZ();
+		}
+	}
+
+	// centre of the bounding box as origin, small phases keep the float kernel accurate
+	if(!posX.empty()){
+		const double centreX(0.5*(*std::min_element(posX.begin(),posX.end())+*std::max_element(posX.begin(),posX.end())));
+		const double centreY(0.5*(*std::min_element(posY.begin(),posY.end())+*std::max_element(posY.begin(),posY.end())));
+		const double centreZ(0.5*(*std::min_element(posZ.begin(),posZ.end())+*std::max_element(posZ.begin(),posZ.end())));
+		for(size_t k=0;k<posX.size();k++){
+			posX[k]-=centreX;
+			posY[k]-=centreY;
+			posZ[k]-=centreZ;
+		}
+	}
 }
 
 /******************************************************************************/
 /**
- * @fn void Analyzer_ChainWalking_Scattering<IngredientsType>::CalcScatteringAmplitude( void )
- * @brief adding a count per strand length interval 
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::ComparePrecision( void )
+ * @brief compares S(q) of attribute 1 from the KernelFloatType kernel with the double kernel
+ * @details Uses the three axes and the space diagonal as directions and all
+ * absolute values of q, and prints the maximum absolute and relative deviation.
  */
-template<class IngredientsType>
-void Analyzer_ChainWalking_Scattering<IngredientsType>::CalcScatteringAmplitude(){
-	// loop over some randomly catched q vectors
-	// for(uint32_t i=0;i<num_of_q;i++){
-	for(uint32_t i=0;i<10;i++){
+template<class IngredientsType, class KernelFloatType>
+void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::ComparePrecision(){
+	if(tagOffsets[polymerGroup+1]==tagOffsets[polymerGroup])
+		return;
+	const size_t first(tagOffsets[polymerGroup]);
+	const size_t n(tagOffsets[polymerGroup+1]-first);
 
-		// get random unit q-vector
-		VectorDouble3 q(GetRandQVector());
+	const double diagonal(1.0/std::sqrt(3.0));
+	const VectorDouble3 directions[4]={VectorDouble3(1.0,0.0,0.0),VectorDouble3(0.0,1.0,0.0),
+	                                   VectorDouble3(0.0,0.0,1.0),VectorDouble3(diagonal,diagonal,diagonal)};
 
-		//loop over some different absolute values of q
+	std::vector<double> projectionDouble(n);
+	std::vector<KernelFloatType> projectionKernel(n);
+	double maxDeviation(0.0), maxRelativeDeviation(0.0);
+	for(size_t d=0;d<4;d++){
+		for(size_t k=0;k<n;k++){
+			projectionDouble[k]=posX[first+k]*directions[d].getX()+posY[first+k]*directions[d].getY()+posZ[first+k]*directions[d].getZ();
+			projectionKernel[k]=KernelFloatType(projectionDouble[k]);
+		}
 		for(uint32_t j=0;j<q_factor.size();j++){
-			// multiply q with a certain number to get equidistant points in log-log plot
-			VectorDouble3 q_j=(((2.0*M_PI)/ingredients.getBoxX())*q_factor.at(j))*q;
-			// scattering amplitude of C_q
-			double_complex C_q(0.0,0.0);
-			//loop over molecules
-			for(uint32_t k=0;k<ingredients.getMolecules().size();k++){
-				// "cast" position vector to double vector
-				VectorDouble3 r (ingredients.getMolecules()[k]);
-				//scalar product of q and monomer position
-				double phi( (double)((-1)*(r*q_j)) );
-				//"cast" to imaginary complex number
-				double_complex iphi(0.0,phi);
-
-				// get factor:
-				double factor = 1.0;
-				if((ingredients.getMolecules()[k].getAttributeTag()==1))
-					factor = 1.0;
-
-				if((ingredients.getMolecules()[k].getAttributeTag()!=1))
-					factor = 0.0;
-
-				// sum over the squared abs of the exponential of iphi
-				C_q+=factor*std::exp(iphi);
-			} /* end loop over molecule */
-			// add C_q depending on q as part of the scattering function to the scattering function container
-			averagedSquaredAbsC_q.at(j)+=((double)(std::real(C_q*std::conj(C_q))));
-			averagedSquaredAbsC_q_elements.at(j)+=1.0;
-		}/* end loop over differnt absolute values of q */
-
-	}/* end loop over random q vectors */
+			double absQ(((2.0*M_PI)/ingredients.getBoxX())*q_factor[j]);
+			double cosDouble, sinDouble, cosKernel, sinKernel;
+			VectorizedSinCos::sumSinCos(&projectionDouble[0],n,absQ,cosDouble,sinDouble);
+			VectorizedSinCos::sumSinCos(&projectionKernel[0],n,KernelFloatType(absQ),cosKernel,sinKernel);
+			double sDouble((cosDouble*cosDouble+sinDouble*sinDouble)/n);
+			double deviation(std::fabs((cosKernel*cosKernel+sinKernel*sinKernel)/n-sDouble));
+			maxDeviation=std::max(maxDeviation,deviation);
+			if(sDouble>0.0)
+				maxRelativeDeviation=std::max(maxRelativeDeviation,deviation/sDouble);
+		}
+	}
+	std::cout << "kernel precision check on the first frame (4 directions, " << q_factor.size() << " q values): "
+	<< "max |S_kernel(q)-S_double(q)| = " << maxDeviation << ", max relative deviation = " << maxRelativeDeviation << std::endl;
+}
+
+/******************************************************************************/
+/**
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::CalcScatteringAmplitude( void )
+ * @brief |C_q|^2 of the current configuration for random q directions
+ * @details The first round samples numDirections directions (or the rotated
+ * direction set) for all q bins.
+ * With a positive relativeErrorTolerance, rounds are repeated for the q bins
+ * that are not converged, until no such bin is left or maxDirections
+ * directions have been drawn.
+ */
+template<class IngredientsType, class KernelFloatType>
+void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::CalcScatteringAmplitude(){
+	CollectScatteringPositions();
+	if(!precisionChecked){
+		ComparePrecision();
+		precisionChecked=true;
+	}
+
+	frameSquaredAbsC_q_squares.assign(num_of_q,0.0);
+	framePartialC_q.assign(averagedPartialC_q.size(),std::vector<double>(num_of_q,0.0));
+
+	activeBins.resize(q_factor.size());
+	for(uint32_t j=0;j<q_factor.size();j++)
+		activeBins[j]=j;
+
+	uint32_t drawnDirections(0);
+	while(!activeBins.empty() && drawnDirections<maxDirections){
+		uint32_t numDirectionsInRound(std::min(numDirections,maxDirections-drawnDirections));
+		if(directionSetSize==0){
+			roundDirections.resize(numDirectionsInRound);
+			for(uint32_t i=0;i<numDirectionsInRound;i++)
+				roundDirections[i]=GetRandQVector(directionGenerator);
+		}else if(rotateDirectionSet){
+			RotateDirectionSet();
+		}
+		SampleDirections(numDirectionsInRound);
+		drawnDirections+=numDirectionsInRound;
+
+		// a fixed direction set gives the same result in every round
+		if(relativeErrorTolerance<=0.0 || (directionSetSize>0 && !rotateDirectionSet))
+			break;
+
+		// keep only the bins above the error tolerance
+		std::vector<uint32_t>::iterator last(activeBins.begin());
+		for(size_t b=0;b<activeBins.size();b++)
+			if(!IsConverged(activeBins[b]))
+				*(last++)=activeBins[b];
+		activeBins.erase(last,activeBins.end());
+	}
+}
+
+/******************************************************************************/
+/**
+ * @fn bool Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::IsConverged( uint32_t bin ) const
+ * @brief checks the relative standard error of |C_q|^2 in the current frame
+ */
+template<class IngredientsType, class KernelFloatType>
+bool Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::IsConverged(uint32_t bin) const{
+	const double n(frameSquaredAbsC_q_elements[bin]);
+	if(n<2.0)
+		return false;
+	const double mean(frameSquaredAbsC_q[bin]/n);
+	if(mean<=0.0)
+		return true;
+	const double variance(std::max(0.0,(frameSquaredAbsC_q_squares[bin]-n*mean*mean)/(n-1.0)));
+	return std::sqrt(variance/n) <= relativeErrorTolerance*mean;
 }
 
 /******************************************************************************/
 /**
- * @fn VectorDouble3 Analyzer_ChainWalking_Scattering<IngredientsType>::GetRandQVector()
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::SampleDirections( uint32_t numDirectionsInRound )
+ * @brief samples |C_q|^2 of all activeBins for numDirectionsInRound random directions
+ * @details The projection r*q of every scattering monomer is calculated once per
+ * direction. The phase sums for all absolute values of q are then evaluated by the
+ * SIMD kernel of VectorizedSinCos instead of calling std::exp for every term.
+ * The squared amplitude does not depend on the sign of the phase, so
+ * |SUM exp(-i q*r)|^2 = (SUM cos(q*r))^2 + (SUM sin(q*r))^2.
+ * Directions are processed in parallel, all absolute values of one direction
+ * stay on the worker that holds its projection. The phases of every monomer are
+ * evaluated once, the amplitudes of the tags are sums over their part of the arrays.
+ * The results of every direction are added to the frame in direction order
+ * after all workers have finished.
+ * Convergence is checked for the attribute 1 amplitude only.
+ */
+template<class IngredientsType, class KernelFloatType>
+void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::SampleDirections(uint32_t numDirectionsInRound){
+	const size_t numScattering(posX.size());
+	const size_t numActive(activeBins.size());
+	const size_t numPairs(averagedPartialC_q.size());
+
+	directionSquaredAbsC_q.resize(size_t(numDirectionsInRound)*numActive);
+	directionPartialC_q.resize(size_t(numDirectionsInRound)*numActive*numPairs);
+
+	ParallelTasks::runOnThreads(numThreads,[&](uint32_t threadId){
+		DirectionWorker& worker(directionWorkers[threadId]);
+		worker.projection.resize(numScattering);
+
+		// loop over the randomly catched q vectors of this worker
+		for(uint32_t i=threadId;i<numDirectionsInRound;i+=numThreads){
+
+			// random unit q-vector or vector of the rotated set, drawn before the loop
+			const VectorDouble3& q(roundDirections[i]);
+			const double qx(q.getX());
+			const double qy(q.getY());
+			const double qz(q.getZ());
+
+			// projection onto the unit q-vector, shared by all absolute values of q
+			for(size_t k=0;k<numScattering;k++)
+				worker.projection[k]=KernelFloatType(posX[k]*qx+posY[k]*qy+posZ[k]*qz);
+
+			//loop over the absolute values of q that are not converged
+			for(size_t b=0;b<numActive;b++){
+				const uint32_t j(activeBins[b]);
+				const size_t sample(size_t(i)*numActive+b);
+				// multiply q with a certain number to get equidistant points in log-log plot
+				double absQ(((2.0*M_PI)/ingredients.getBoxX())*q_factor[j]);
+				// real and imaginary part of the scattering amplitude C_q of every tag
+				for(size_t g=0;g<scatteringTags.size();g++){
+					worker.tagCos[g]=0.0;
+					worker.tagSin[g]=0.0;
+					if(tagOffsets[g+1]>tagOffsets[g])
+						VectorizedSinCos::sumSinCos(&worker.projection[tagOffsets[g]],tagOffsets[g+1]-tagOffsets[g],KernelFloatType(absQ),worker.tagCos[g],worker.tagSin[g]);
+				}
+				if(computePartials){
+					for(size_t a=0;a<scatteringTags.size();a++)
+						for(size_t b=a;b<scatteringTags.size();b++)
+							directionPartialC_q[sample*numPairs+PairIndex(a,b)]=worker.tagCos[a]*worker.tagCos[b]+worker.tagSin[a]*worker.tagSin[b];
+				}
+
+				directionSquaredAbsC_q[sample]=worker.tagCos[polymerGroup]*worker.tagCos[polymerGroup]+worker.tagSin[polymerGroup]*worker.tagSin[polymerGroup];
+			}/* end loop over differnt absolute values of q */
+
+		}/* end loop over random q vectors */
+	});
+
+	// add the directions to the frame in direction order, independent of numThreads
+	for(uint32_t i=0;i<numDirectionsInRound;i++){
+		for(size_t b=0;b<numActive;b++){
+			const uint32_t j(activeBins[b]);
+			const size_t sample(size_t(i)*numActive+b);
+			const double squaredAbsC_q(directionSquaredAbsC_q[sample]);
+			frameSquaredAbsC_q[j]+=squaredAbsC_q;
+			frameSquaredAbsC_q_squares[j]+=squaredAbsC_q*squaredAbsC_q;
+			frameSquaredAbsC_q_elements[j]+=1.0;
+			for(size_t p=0;p<numPairs;p++)
+				framePartialC_q[p][j]+=directionPartialC_q[sample*numPairs+p];
+		}
+	}
+}
+
+/******************************************************************************/
+/**
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::CalcScatteringAmplitudeFFT( void )
+ * @brief |C_q|^2 at all lattice wave vectors, binned onto q_factor
+ * @details The monomer positions are folded into the periodic box. For the
+ * commensurate wave vectors this does not change C_q. The wave vector q=0
+ * is skipped.
+ */
+template<class IngredientsType, class KernelFloatType>
+void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::CalcScatteringAmplitudeFFT(){
+	const int32_t boxX(ingredients.getBoxX());
+	const int32_t boxY(ingredients.getBoxY());
+	const int32_t boxZ(ingredients.getBoxZ());
+
+	densityGrid.assign(size_t(boxX)*size_t(boxY)*size_t(boxZ),double_complex(0.0,0.0));
+	for(uint32_t k=0;k<ingredients.getMolecules().size();k++){
+		if(ingredients.getMolecules()[k].getAttributeTag()==1){
+			int32_t x(((ingredients.getMolecules()[k].getX()%boxX)+boxX)%boxX);
+			int32_t y(((ingredients.getMolecules()[k].getY()%boxY)+boxY)%boxY);
+			int32_t z(((ingredients.getMolecules()[k].getZ()%boxZ)+boxZ)%boxZ);
+			densityGrid[x+size_t(boxX)*(y+size_t(boxY)*z)]+=1.0;
+		}
+	}
+
+	latticeTransform.transform(densityGrid);
+
+	// q is written in units of 2 pi/L_x
+	for(int32_t z=0;z<boxZ;z++){
+		double nz((z<=boxZ/2) ? z : z-boxZ);
+		for(int32_t y=0;y<boxY;y++){
+			double ny((y<=boxY/2) ? y : y-boxY);
+			for(int32_t x=0;x<boxX;x++){
+				if(x==0 && y==0 && z==0)
+					continue;
+				double nx((x<=boxX/2) ? x : x-boxX);
+				double qfactor(boxX*std::sqrt(nx*nx/(1.0*boxX*boxX)+ny*ny/(1.0*boxY*boxY)+nz*nz/(1.0*boxZ*boxZ)));
+				int32_t bin(GetQBin(qfactor));
+				if(bin<0)
+					continue;
+				frameSquaredAbsC_q[bin]+=std::norm(densityGrid[x+size_t(boxX)*(y+size_t(boxY)*z)]);
+				frameSquaredAbsC_q_elements[bin]+=1.0;
+			}
+		}
+	}
+}
+
+/******************************************************************************/
+/**
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::CalcScatteringAmplitudeDebye( void )
+ * @brief orientational average of |C_q|^2 from the pair distance histogram
+ * @details Rows of the pair matrix are dealt round robin to the threads, which
+ * balances the triangular loop. Distances are taken from the positions as
+ * stored in the molecules, like in the random direction mode.
+ */
+template<class IngredientsType, class KernelFloatType>
+void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::CalcScatteringAmplitudeDebye(){
+	std::vector<int32_t> x, y, z;
+	for(uint32_t k=0;k<ingredients.getMolecules().size();k++){
+		if(ingredients.getMolecules()[k].getAttributeTag()==1){
+			x.push_back(ingredients.getMolecules()[k].getX());
+			y.push_back(ingredients.getMolecules()[k].getY());
+			z.push_back(ingredients.getMolecules()[k].getZ());
+		}
+	}
+	const size_t numScattering(x.size());
+	if(numScattering==0)
+		return;
+
+	// the largest squared distance follows from the bounding box
+	const int64_t extentX(*std::max_element(x.begin(),x.end()) - *std::min_element(x.begin(),x.end()));
+	const int64_t extentY(*std::max_element(y.begin(),y.end()) - *std::min_element(y.begin(),y.end()));
+	const int64_t extentZ(*std::max_element(z.begin(),z.end()) - *std::min_element(z.begin(),z.end()));
+	const uint64_t maxR2(extentX*extentX+extentY*extentY+extentZ*extentZ);
+
+	pairDistanceHistograms.resize(numThreads);
+	for(uint32_t t=0;t<numThreads;t++){
+		pairDistanceHistograms[t].reserve(maxR2);
+		pairDistanceHistograms[t].clear();
+	}
+	ParallelTasks::runOnThreads(numThreads,[&](uint32_t threadId){
+		PairDistanceHistogram& histogram(pairDistanceHistograms[threadId]);
+		for(size_t i=threadId;i<numScattering;i+=numThreads){
+			const int64_t xi(x[i]), yi(y[i]), zi(z[i]);
+			for(size_t j=i+1;j<numScattering;j++){
+				int64_t dx(x[j]-xi), dy(y[j]-yi), dz(z[j]-zi);
+				histogram.add(uint64_t(dx*dx+dy*dy+dz*dz));
+			}
+		}
+	});
+
+	// reduce into a sparse list of occupied distances,
+	// monomers on the same site contribute like the self term
+	for(uint32_t t=1;t<numThreads;t++)
+		pairDistanceHistograms[0].merge(pairDistanceHistograms[t]);
+	std::vector<const PairDistanceHistogram*> parts(1,&pairDistanceHistograms[0]);
+	std::vector<double> distance, pairs;
+	const double samePosition(PairDistanceHistogram::collect(parts,std::vector<double>(1,1.0),distance,pairs));
+
+	for(uint32_t j=0;j<q_factor.size();j++){
+		double absQ(((2.0*M_PI)/ingredients.getBoxX())*q_factor.at(j));
+		double sum(0.0);
+		for(size_t n=0;n<distance.size();n++)
+			sum+=pairs[n]*std::sin(absQ*distance[n])/(absQ*distance[n]);
+		frameSquaredAbsC_q[j]+=double(numScattering)+2.0*(samePosition+sum);
+		frameSquaredAbsC_q_elements[j]+=1.0;
+	}
+}
+
+/******************************************************************************/
+/**
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::InitMolecules( void )
+ * @brief finds the molecules with attribute 1 monomers from the bonds of the first configuration
+ */
+template<class IngredientsType, class KernelFloatType>
+void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::InitMolecules(){
+	moleculeIndex.build(ingredients.getMolecules());
+
+	formFactorMolecules.clear();
+	formFactorSizeClass.clear();
+	formFactorSizes.clear();
+	for(size_t m=0;m<moleculeIndex.getNumMolecules();m++){
+		const uint32_t* block(moleculeIndex.getMonomers(m));
+		uint32_t numScattering(0);
+		for(size_t k=0;k<moleculeIndex.getMoleculeSize(m);k++)
+			if(ingredients.getMolecules()[block[k]].getAttributeTag()==1)
+				numScattering++;
+		if(numScattering==0)
+			continue;
+
+		std::vector<uint32_t>::iterator size(std::find(formFactorSizes.begin(),formFactorSizes.end(),numScattering));
+		formFactorMolecules.push_back(m);
+		formFactorSizeClass.push_back(size-formFactorSizes.begin());
+		if(size==formFactorSizes.end())
+			formFactorSizes.push_back(numScattering);
+	}
+	if(formFactorMolecules.empty())
+		throw std::runtime_error("Analyzer_ChainWalking_Scattering: no molecule with attribute 1 monomers");
+
+	moleculeWorkers.resize(numThreads);
+	for(uint32_t t=0;t<numThreads;t++)
+		moleculeWorkers[t].histograms.assign(formFactorSizes.size(),PairDistanceHistogram());
+}
+
+/******************************************************************************/
+/**
+ * @fn void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::CalcMoleculeFormFactor( void )
+ * @brief molecule averaged form factor of the current configuration
+ * @details P(q) = 1 + 2/M SUM_m 1/N_m SUM_(pairs in m) sin(qr)/(qr). The pair
+ * counts are integers per number of scattering monomers N, so the reduction
+ * over the threads is exact and the weights 1/N are applied once per frame.
+ */
+template<class IngredientsType, class KernelFloatType>
+void Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::CalcMoleculeFormFactor(){
+	ParallelTasks::parallelFor(formFactorMolecules.size(),numThreads,[&](size_t item, uint32_t threadId){
+		MoleculeWorker& worker(moleculeWorkers[threadId]);
+		const uint32_t m(formFactorMolecules[item]);
+		const size_t size(moleculeIndex.getMoleculeSize(m));
+		if(worker.x.size()<size){
+			worker.x.resize(size);
+			worker.y.resize(size);
+			worker.z.resize(size);
+		}
+		moleculeIndex.unwrap(ingredients,m,&worker.x[0],&worker.y[0],&worker.z[0]);
+
+		// compact the block to the scattering monomers
+		const uint32_t* block(moleculeIndex.getMonomers(m));
+		size_t n(0);
+		for(size_t k=0;k<size;k++){
+			if(ingredients.getMolecules()[block[k]].getAttributeTag()==1){
+				worker.x[n]=worker.x[k];
+				worker.y[n]=worker.y[k];
+				worker.z[n]=worker.z[k];
+				n++;
+			}
+		}
+
+		const int32_t* x(&worker.x[0]);
+		const int32_t* y(&worker.y[0]);
+		const int32_t* z(&worker.z[0]);
+		const int64_t extentX(*std::max_element(x,x+n) - *std::min_element(x,x+n));
+		const int64_t extentY(*std::max_element(y,y+n) - *std::min_element(y,y+n));
+		const int64_t extentZ(*std::max_element(z,z+n) - *std::min_element(z,z+n));
+		const uint64_t maxR2(extentX*extentX+extentY*extentY+extentZ*extentZ);
+
+		PairDistanceHistogram& histogram(worker.histograms[formFactorSizeClass[item]]);
+		histogram.reserve(maxR2);
+		for(size_t i=0;i<n;i++){
+			const int64_t xi(x[i]), yi(y[i]), zi(z[i]);
+			for(size_t j=i+1;j<n;j++){
+				int64_t dx(x[j]-xi), dy(y[j]-yi), dz(z[j]-zi);
+				histogram.add(uint64_t(dx*dx+dy*dy+dz*dz));
+			}
+		}
+	});
+
+	// reduce into a sparse list of occupied distances weighted with 1/N,
+	// the counts of the threads are merged first and the result does not
+	// depend on which thread evaluated which molecule
+	std::vector<const PairDistanceHistogram*> parts;
+	std::vector<double> partWeights;
+	for(size_t c=0;c<formFactorSizes.size();c++){
+		for(uint32_t t=1;t<numThreads;t++)
+			moleculeWorkers[0].histograms[c].merge(moleculeWorkers[t].histograms[c]);
+		parts.push_back(&moleculeWorkers[0].histograms[c]);
+		partWeights.push_back(1.0/double(formFactorSizes[c]));
+	}
+	std::vector<double> distance, weight;
+	const double samePosition(PairDistanceHistogram::collect(parts,partWeights,distance,weight));
+	for(uint32_t t=0;t<numThreads;t++)
+		for(size_t c=0;c<formFactorSizes.size();c++)
+			moleculeWorkers[t].histograms[c].clear();
+
+	const double numMolecules(formFactorMolecules.size());
+	for(uint32_t j=0;j<q_factor.size();j++){
+		double absQ(((2.0*M_PI)/ingredients.getBoxX())*q_factor.at(j));
+		double sum(0.0);
+		for(size_t n=0;n<distance.size();n++)
+			sum+=weight[n]*std::sin(absQ*distance[n])/(absQ*distance[n]);
+		frameSquaredAbsC_q[j]+=1.0+2.0*(samePosition+sum)/numMolecules;
+		frameSquaredAbsC_q_elements[j]+=1.0;
+	}
+}
+
+/******************************************************************************/
+/**
+ * @fn VectorDouble3 Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::GetRandQVector(std::mt19937& generator)
  * @brief get a randomly orientated 3D Vector 
+ * @param generator random number stream of the q directions
  * @return VectorDouble3 q, restricted to the unit sphere
  */
-template<class IngredientsType>
-VectorDouble3 Analyzer_ChainWalking_Scattering<IngredientsType>::GetRandQVector(){
-  VectorDouble3 q(1.0,1.0,1.0);
-  //get three random numbers in [-1,1] 
-  double a((rng.r250_drand()*2)-1);
-  double b((rng.r250_drand()*2)-1);
-  double c((rng.r250_drand()*2)-1);
-  //check them to be inside the unit sphere
-  if((a*a+b*b+c*c)<=1){
-    // if yes, set them as coordinates for q
-    q.setX(a); q.setY(b); q.setZ(c);
-  }else if((a*a+b*b+c*c)>1){
-    // if not, do an iterative call of GetRandQVector to get another set of random coordinates
-    q=GetRandQVector();
-  }
+template<class IngredientsType, class KernelFloatType>
+VectorDouble3 Analyzer_ChainWalking_Scattering<IngredientsType,KernelFloatType>::GetRandQVector(std::mt19937& generator){
+  std::uniform_real_distribution<double> uniform(-1.0,1.0);
+  double a, b, c, r2;
+  //draw three random numbers in [-1,1] until they are inside the unit sphere
+  do{
+    a=uniform(generator);
+    b=uniform(generator);
+    c=uniform(generator);
+    r2=a*a+b*b+c*c;
+  }while(r2>1.0 || r2==0.0);
+  VectorDouble3 q(a,b,c);
   q.normalize();
   return q;
 }
@@ -1,6 +1,8 @@
 
 
 #include <cstring>
+#include <random>
+#include <stdexcept>
 #include <stdlib.h> //for atoi
 #include <unistd.h> //for getopt
 
@@ -37,10 +39,36 @@ int main(int argc, char* argv[])
 
 	long evalulation_time = 0;
 
+	int mode = 0;
+
+	uint32_t numThreads = ParallelTasks::getDefaultNumThreads();
+
+	uint32_t numDirections = 10;
+
+	double relativeErrorTolerance = 0.0;
+
+	uint32_t maxDirections = 100;
+
+	bool computePartials = false;
+
+	uint32_t directionSetSize = 0;
+
+	bool rotateDirectionSet = true;
+
+	bool writeSeries = false;
+
+	double seriesFlushInterval = 60.0;
+
+	bool fixedSeed = false;
+
+	uint32_t seed = 0;
+
+	bool singlePrecision = false;
+
 	int option_char(0);
 
 	//read in options by getopt
-	while ((option_char = getopt (argc, argv, "f:n:e:h"))  != EOF){
+	while ((option_char = getopt (argc, argv, "f:n:e:m:t:d:a:x:ps:Rwi:FS:h"))  != EOF){
 		switch (option_char)
 		{
 		case 'f':
@@ -49,6 +77,37 @@ int main(int argc, char* argv[])
 
 		case 'e': evalulation_time = atol(optarg);
 				  break;
+		case 'm': mode = atoi(optarg);
+				  break;
+		case 't': numThreads = ParallelTasks::parseNumThreads(optarg);
+				  break;
+		case 'd': numDirections = atoi(optarg);
+				  break;
+		case 'a': relativeErrorTolerance = atof(optarg);
+				  break;
+		case 'x': maxDirections = atoi(optarg);
+				  break;
+		case 'p': computePartials = true;
+				  break;
+		case 's': directionSetSize = atoi(optarg);
+				  break;
+		case 'R': rotateDirectionSet = false;
+				  break;
+		case 'w': writeSeries = true;
+				  break;
+		case 'i': seriesFlushInterval = atof(optarg);
+				  break;
+		case 'F': singlePrecision = true;
+				  break;
+		case 'S': {
+				  char* end(0);
+				  const unsigned long value(strtoul(optarg,&end,10));
+				  if(end==optarg || *end!='\0' || optarg[0]=='-' || value>0xFFFFFFFFul)
+					  throw std::runtime_error("seed must be an unsigned 32 bit integer");
+				  seed = uint32_t(value);
+				  fixedSeed = true;
+				  }
+				  break;
 		//case 'n':
 		//	number_of_monomers = atoi(optarg);
 		//	break;
@@ -58,22 +117,60 @@ int main(int argc, char* argv[])
 		case 'h':
 		default:
 			//std::cerr << "Usage: " << argv[0] << " [-f filename] [-n number_of_monomers] [-p probability] \n";
-			std::cerr << "Usage: " << argv[0] << " [-f filename(=test.bfm)] [-e evaluation_time(=0)] \n";
+			std::cerr << "Usage: " << argv[0] << " [-f filename(=test.bfm)] [-e evaluation_time(=0)]\n"
+					  << "    [-m mode(=0): 0 random q directions, 1 FFT of the lattice, 2 Debye pair histogram,\n"
+					  << "                 3 form factor per molecule]\n"
+					  << "    [-t threads(=all cores)] [-d q_directions_per_frame(=10)]\n"
+					  << "    [-a adaptive_relative_error(=0, off)] [-x max_q_directions_per_frame(=100)]\n"
+					  << "    [-p partial structure factors of all attribute tag pairs (mode 0 only)]\n"
+					  << "    [-s size_of_Fibonacci_direction_set(=0, random directions)] [-R do not rotate the direction set]\n"
+					  << "    [-w write the per frame time series _ScatteringSeries.bin]\n"
+					  << "    [-i seconds after which the time series is written also if its 1 MiB block is not full(=60, 0 never)]\n"
+					  << "    [-F single precision phase kernel (mode 0 only)]\n"
+					  << "    [-S seed of the random q directions(=random), results do not depend on -t]\n";
 
 			return 0;
 		}
 	}
 
-	//seed the globally available random number generators
+	//seed the globally available random number generators,
+	//with -S from a fixed seed to reproduce the q directions
     RandomNumberGenerators randomNumbers;
-    randomNumbers.seedAll();
+    if(fixedSeed){
+        std::mt19937 seedGenerator(seed);
+        uint32_t seedArray[256];
+        for(int i=0;i<256;i++)
+            seedArray[i]=seedGenerator();
+        randomNumbers.seedR250(seedArray);
+    }else{
+        randomNumbers.seedAll();
+    }
 
     myIngredients.setName(filename);
 
     TaskManager taskmanager;
     taskmanager.addUpdater(new UpdaterReadBfmFile<Ing>(filename,myIngredients,UpdaterReadBfmFile<Ing>::READ_STEPWISE));
 
-    taskmanager.addAnalyzer(new Analyzer_ChainWalking_Scattering<Ing>(myIngredients, evalulation_time));
+    if(mode < Analyzer_ChainWalking_Scattering<Ing>::RANDOM_DIRECTIONS || mode > Analyzer_ChainWalking_Scattering<Ing>::MOLECULE_FORM_FACTOR)
+        throw std::runtime_error("unknown scattering mode");
+
+    // the settings are shared by both precisions of the phase kernel
+    ChainWalkingScatteringSettings::Options options;
+    options.mode = static_cast<ChainWalkingScatteringSettings::ScatteringMode>(mode);
+    options.numThreads = numThreads;
+    options.numDirections = numDirections;
+    options.relativeErrorTolerance = relativeErrorTolerance;
+    options.maxDirections = maxDirections;
+    options.computePartials = computePartials;
+    options.directionSetSize = directionSetSize;
+    options.rotateDirectionSet = rotateDirectionSet;
+    options.writeSeries = writeSeries;
+    options.seriesFlushInterval = seriesFlushInterval;
+
+    if(singlePrecision)
+        taskmanager.addAnalyzer(new Analyzer_ChainWalking_Scattering<Ing,float>(myIngredients, evalulation_time, 0, 1, options));
+    else
+        taskmanager.addAnalyzer(new Analyzer_ChainWalking_Scattering<Ing>(myIngredients, evalulation_time, 0, 1, options));
 
     taskmanager.initialize();
     taskmanager.run();
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <stdlib.h> //for atol
+#include <unistd.h> //for getopt
+
+#include "ScatteringSeries.h"
+
+/*****************************************************************************/
+/**
+ * @file
+ * @brief rebuilds the averaged scattering function from a _ScatteringSeries.bin file
+ * @details The series may be incomplete, e.g. if the analysis was killed. All
+ * complete frames are averaged.
+ * */
+/*****************************************************************************/
+int main(int argc, char* argv[])
+{
+  try{
+	std::string filename="test_ScatteringSeries.bin";
+
+	std::string outputFilename;
+
+	uint64_t minAge = 0;
+
+	uint64_t maxFrames = 0;
+
+	int option_char(0);
+
+	//read in options by getopt
+	while ((option_char = getopt (argc, argv, "f:o:e:n:h"))  != EOF){
+		switch (option_char)
+		{
+		case 'f':
+			filename=optarg;
+			break;
+		case 'o':
+			outputFilename=optarg;
+			break;
+		case 'e': minAge = atol(optarg);
+				  break;
+		case 'n': maxFrames = atol(optarg);
+				  break;
+		case 'h':
+		default:
+			std::cerr << "Usage: " << argv[0] << " [-f series_file(=test_ScatteringSeries.bin)] [-o output(=<name>_ScatteringFct.dat)]\n"
+					  << "    [-e skip frames up to this age(=0)] [-n max_number_of_frames(=0, all)]\n";
+			return 0;
+		}
+	}
+
+	if(outputFilename.empty()){
+		const std::string suffix("_ScatteringSeries.bin");
+		outputFilename=filename;
+		if(outputFilename.length()>suffix.length() && outputFilename.compare(outputFilename.length()-suffix.length(),suffix.length(),suffix)==0)
+			outputFilename.erase(outputFilename.length()-suffix.length());
+		outputFilename+="_ScatteringFct.dat";
+	}
+
+	uint64_t numFrames(ScatteringSeries::writeAverage(filename,outputFilename,minAge,maxFrames));
+	std::cout << "averaged " << numFrames << " frames of " << filename << " into " << outputFilename << std::endl;
+
+	}
+	catch(std::exception& err){std::cerr<<err.what();}
+	return 0;
+}
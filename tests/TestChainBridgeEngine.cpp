@@ -0,0 +1,209 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief ChainBridgeEngine against all-pairs breadth first search shortest paths
+ * @details Builds linear chains, rings, trees, networks and single monomers,
+ * compares every contour distance with the shortest bond path found by a
+ * breadth first search from every monomer and every classification of
+ * random contact sets with the criterion evaluated on these paths. On
+ * networks the distances only have to be upper bounds of the shortest path.
+ * */
+/*****************************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include "ChainBridgeEngine.h"
+#include "TestSystem.h"
+
+//! adds a molecule of the given shape and size, returns the index of its first monomer
+uint32_t addMolecule(TestMolecules& molecules, ChainBridgeEngine::ChainShape shape, uint32_t size)
+{
+	const uint32_t first(uint32_t(molecules.size()));
+	for(uint32_t k=0;k<size;k++)
+		molecules.addMonomer(VectorInt3(0,0,0),1);
+
+	switch(shape){
+	case ChainBridgeEngine::LINEAR:
+	case ChainBridgeEngine::RING:
+		for(uint32_t k=1;k<size;k++)
+			molecules.connect(first+k-1,first+k);
+		if(shape==ChainBridgeEngine::RING)
+			molecules.connect(first,first+size-1);
+		break;
+	case ChainBridgeEngine::BRANCHED:
+	case ChainBridgeEngine::NETWORK:
+		// random tree with at most 4 bonds per monomer, the network gets one more bond
+		for(uint32_t k=1;k<size;k++){
+			uint32_t parent;
+			do{
+				parent=first+uint32_t(std::rand())%k;
+			}while(molecules.getNumLinks(parent)>=4);
+			molecules.connect(parent,first+k);
+		}
+		// the extra bond must not close a path into a simple ring
+		if(shape==ChainBridgeEngine::NETWORK){
+			bool isPath(true);
+			for(uint32_t k=0;k<size;k++)
+				isPath=isPath && molecules.getNumLinks(first+k)<=2;
+			uint32_t a, b;
+			do{
+				a=first+uint32_t(std::rand())%size;
+				b=first+uint32_t(std::rand())%size;
+			}while(a==b || molecules.areConnected(a,b) || molecules.getNumLinks(a)>=4 || molecules.getNumLinks(b)>=4
+			       || (isPath && molecules.getNumLinks(a)==1 && molecules.getNumLinks(b)==1));
+			molecules.connect(a,b);
+		}
+		break;
+	}
+	return first;
+}
+
+//! number of bonds of the shortest path from source to every monomer, -1 for other molecules
+std::vector<int32_t> shortestPaths(const TestMolecules& molecules, uint32_t source)
+{
+	std::vector<int32_t> distance(molecules.size(),-1);
+	std::queue<uint32_t> queue;
+	distance[source]=0;
+	queue.push(source);
+	while(!queue.empty()){
+		const uint32_t current(queue.front());
+		queue.pop();
+		for(uint32_t l=0;l<molecules.getNumLinks(current);l++){
+			const uint32_t neighbor(molecules.getNeighborIdx(current,l));
+			if(distance[neighbor]<0){
+				distance[neighbor]=distance[current]+1;
+				queue.push(neighbor);
+			}
+		}
+	}
+	return distance;
+}
+
+int main()
+{
+	TestReport report("TestChainBridgeEngine");
+	std::srand(7);
+
+	const uint32_t minContourSpan(5);
+
+	TestMolecules molecules;
+	std::vector<uint32_t> moleculeOf;
+	std::vector<ChainBridgeEngine::ChainShape> shapeOf;
+	std::vector<uint32_t> firstOf;
+	// linear chains, rings, trees and networks in turn, every 20th molecule a single monomer
+	for(uint32_t m=0;m<60;m++){
+		const ChainBridgeEngine::ChainShape shape(ChainBridgeEngine::ChainShape(m%4));
+		const uint32_t size((m%20==16) ? 1 : 4+uint32_t(std::rand())%40);
+		const uint32_t first(addMolecule(molecules,shape,size));
+
+		// small trees may be paths
+		uint32_t maxLinks(0);
+		for(uint32_t k=0;k<size;k++)
+			maxLinks=std::max(maxLinks,molecules.getNumLinks(first+k));
+		firstOf.push_back(first);
+		moleculeOf.insert(moleculeOf.end(),size,m);
+		shapeOf.push_back((shape==ChainBridgeEngine::BRANCHED && maxLinks<=2) ? ChainBridgeEngine::LINEAR : shape);
+	}
+	// a comb deep enough for many levels of ancestors
+	const uint32_t combSize(1500);
+	const uint32_t comb(addMolecule(molecules,ChainBridgeEngine::LINEAR,1000));
+	for(uint32_t k=1000;k<combSize;k++){
+		uint32_t parent;
+		do{
+			parent=comb+uint32_t(std::rand())%k;
+		}while(molecules.getNumLinks(parent)>=4);
+		molecules.addMonomer(VectorInt3(0,0,0),1);
+		molecules.connect(parent,comb+k);
+	}
+	moleculeOf.insert(moleculeOf.end(),combSize,60);
+	shapeOf.push_back(ChainBridgeEngine::BRANCHED);
+	firstOf.push_back(comb);
+
+	ChainBridgeEngine engine(minContourSpan);
+	engine.build(molecules);
+
+	const uint32_t numMonomers(uint32_t(molecules.size()));
+	std::vector< std::vector<int32_t> > distance(numMonomers);
+	for(uint32_t a=0;a<numMonomers;a++)
+		distance[a]=shortestPaths(molecules,a);
+
+	report.check(engine.getNumChains()==shapeOf.size(),"number of chains");
+
+	size_t numNetworks(0);
+	for(size_t m=0;m<shapeOf.size();m++){
+		numNetworks+=(shapeOf[m]==ChainBridgeEngine::NETWORK);
+		std::stringstream what;
+		what << "shape of molecule " << m;
+		report.check(engine.getChainShape(engine.getChain(firstOf[m]))==shapeOf[m],what.str());
+	}
+	report.check(engine.getNumNetworkChains()==numNetworks,"number of networks");
+
+	int32_t maxDistance(0);
+	for(uint32_t a=0;a<numMonomers;a++){
+		for(uint32_t b=0;b<numMonomers;b++){
+			if(moleculeOf[a]!=moleculeOf[b])
+				continue;
+			maxDistance=std::max(maxDistance,distance[a][b]);
+
+			const int32_t contour(int32_t(engine.getContourDistance(a,b)));
+			std::stringstream what;
+			what << "contour distance " << a << " " << b << ": " << contour << " shortest path " << distance[a][b];
+			if(shapeOf[moleculeOf[a]]==ChainBridgeEngine::NETWORK)
+				report.check(contour>=distance[a][b] && contour<=int32_t(engine.getMaxContourSpan()),what.str());
+			else
+				report.check(contour==distance[a][b],what.str());
+		}
+	}
+	report.check(int32_t(engine.getMaxContourSpan())>=maxDistance,"bound of the contour spans");
+
+	// contact sets of up to MAX_CONTACTS monomers, mostly from the neighbourhood of one index
+	for(int test=0;test<20000;test++){
+		const uint32_t numContacts(1+uint32_t(std::rand())%((test%10==0) ? uint32_t(ChainBridgeEngine::MAX_CONTACTS) : 12));
+		const uint32_t base(uint32_t(std::rand())%numMonomers);
+		std::set<uint32_t> used;
+		uint32_t contacts[ChainBridgeEngine::MAX_CONTACTS];
+		for(uint32_t i=0;i<numContacts;i++){
+			uint32_t contact;
+			do{
+				contact=(std::rand()%3==0) ? uint32_t(std::rand())%numMonomers
+				                           : uint32_t(std::max(0,std::min(int32_t(numMonomers)-1,int32_t(base)+std::rand()%60-30)));
+			}while(used.count(contact));
+			used.insert(contact);
+			contacts[i]=contact;
+		}
+
+		const ChainBridgeEngine::Bridge bridge(engine.classify(contacts,numContacts));
+
+		std::set<uint32_t> chains;
+		int32_t span(0);
+		bool onNetwork(false);
+		for(uint32_t i=0;i<numContacts;i++){
+			chains.insert(moleculeOf[contacts[i]]);
+			for(uint32_t j=i+1;j<numContacts;j++){
+				if(moleculeOf[contacts[i]]!=moleculeOf[contacts[j]])
+					continue;
+				span=std::max(span,distance[contacts[i]][contacts[j]]);
+				onNetwork=onNetwork || shapeOf[moleculeOf[contacts[i]]]==ChainBridgeEngine::NETWORK;
+			}
+		}
+
+		std::stringstream what;
+		what << "classification " << test;
+		report.check(bridge.numContacts==numContacts,what.str()+" number of contacts");
+		report.check(bridge.numChains==chains.size(),what.str()+" number of chains");
+		report.check(bridge.isInterChain==(chains.size()>1),what.str()+" inter-chain");
+		if(onNetwork){
+			report.check(int32_t(bridge.maxContourSpan)>=span,what.str()+" span on a network");
+		}else{
+			report.check(int32_t(bridge.maxContourSpan)==span,what.str()+" span");
+			report.check(bridge.isIntraChain==(span>=int32_t(minContourSpan)),what.str()+" intra-chain");
+		}
+	}
+
+	return report.finish();
+}
@@ -0,0 +1,90 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief IntegerHistogram against directly counted values
+ * @details Checks the counts, the overflow and the mean, that merging the
+ * histograms of parts of the values gives the histogram of all values in any
+ * order, and the trimmed output columns.
+ * */
+/*****************************************************************************/
+
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "IntegerHistogram.h"
+#include "TestSystem.h"
+
+int main()
+{
+	TestReport report("TestIntegerHistogram");
+	std::srand(5);
+
+	const size_t numBins(20);
+	const size_t numParts(4);
+
+	IntegerHistogram all(numBins);
+	std::vector<IntegerHistogram> parts(numParts,IntegerHistogram(numBins));
+	std::vector<uint64_t> expected(numBins,0);
+	uint64_t expectedOverflow(0), expectedSum(0);
+
+	const size_t numValues(10000);
+	for(size_t i=0;i<numValues;i++){
+		// values beyond the last bin, but none in the last two bins
+		uint64_t value(uint64_t(std::rand())%(numBins+10));
+		if(value==numBins-1 || value==numBins-2)
+			value=0;
+		all.add(value);
+		parts[i%numParts].add(value);
+		if(value<numBins)
+			expected[value]++;
+		else
+			expectedOverflow++;
+		expectedSum+=value;
+	}
+
+	report.check(all.getNumBins()==numBins,"number of bins");
+	report.check(all.getNumSamples()==numValues,"number of samples");
+	report.check(all.getNumOverflow()==expectedOverflow,"overflow");
+	report.check(std::fabs(all.getMean()-double(expectedSum)/double(numValues))<1e-12,"mean");
+	for(size_t bin=0;bin<numBins;bin++){
+		std::stringstream what;
+		what << "count of " << bin;
+		report.check(all.getCount(bin)==expected[bin],what.str());
+	}
+
+	// merged in reverse order
+	IntegerHistogram merged(numBins);
+	for(size_t p=numParts;p-->0;)
+		merged.merge(parts[p]);
+	report.check(merged.getNumSamples()==all.getNumSamples(),"merged number of samples");
+	report.check(merged.getNumOverflow()==all.getNumOverflow(),"merged overflow");
+	report.check(merged.getMean()==all.getMean(),"merged mean");
+	for(size_t bin=0;bin<numBins;bin++)
+		report.check(merged.getCount(bin)==all.getCount(bin),"merged counts");
+
+	// columns up to the last non-empty bin
+	const std::vector< std::vector<double> > columns(all.getColumns());
+	report.check(columns.size()==3 && columns[0].size()==numBins-2,"trimmed columns");
+	for(size_t bin=0;bin<columns[0].size();bin++){
+		report.check(columns[0][bin]==double(bin),"column of values");
+		report.check(columns[1][bin]==double(expected[bin]),"column of counts");
+		report.check(std::fabs(columns[2][bin]-double(expected[bin])/double(numValues))<1e-15,"column of fractions");
+	}
+
+	merged.clear();
+	report.check(merged.getNumBins()==numBins && merged.getNumSamples()==0 && merged.getColumns()[0].empty(),"clear");
+
+	bool refused(false);
+	try{
+		IntegerHistogram other(numBins+1);
+		all.merge(other);
+	}catch(const std::runtime_error&){
+		refused=true;
+	}
+	report.check(refused,"merge of different number of bins");
+
+	return report.finish();
+}
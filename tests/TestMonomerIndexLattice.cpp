@@ -0,0 +1,100 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief MonomerIndexLattice against the all-pairs criterion diff*diff <= 6
+ * @details For periodic boxes of every size from 1 to 12 along each axis and
+ * for non-periodic boxes, the monomers found by countShell() and
+ * collectShell() have to be exactly those with a squared minimum image
+ * distance of at most 6, as tested pairwise by the analyzers before.
+ * */
+/*****************************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+#include "MonomerIndexLattice.h"
+#include "TestSystem.h"
+
+//! minimum image of the difference d along an axis of length box
+int32_t minimumImage(int32_t d, int32_t box, bool periodic)
+{
+	if(!periodic)
+		return d;
+	d%=box;
+	if(2*d>box)
+		d-=box;
+	if(2*d<-box)
+		d+=box;
+	return d;
+}
+
+void testBox(TestReport& report, uint32_t boxX, uint32_t boxY, uint32_t boxZ, bool periodic)
+{
+	TestIngredients ing(boxX,boxY,boxZ,periodic);
+	TestMolecules& molecules(ing.modifyMolecules());
+
+	// every site holds either a polymer (tag 1) or a cosolvent (tag 2) or nothing
+	const uint32_t numSites(boxX*boxY*boxZ);
+	for(uint32_t site=0;site<numSites;site++){
+		const int r(std::rand()%3);
+		if(r==2)
+			continue;
+		// unfolded positions, the lattice has to fold them
+		const VectorInt3 pos(int32_t(site%boxX)+int32_t(boxX)*(std::rand()%5-2),
+		                     int32_t((site/boxX)%boxY)+int32_t(boxY)*(std::rand()%5-2),
+		                     int32_t(site/(boxX*boxY))+int32_t(boxZ)*(std::rand()%5-2));
+		molecules.addMonomer(periodic ? pos : VectorInt3(site%boxX,(site/boxX)%boxY,site/(boxX*boxY)),1+r);
+	}
+
+	MonomerIndexLattice lattice;
+	lattice.setup(ing);
+	lattice.update(ing,1);
+
+	std::vector<uint32_t> found;
+	uint32_t buffer[MonomerIndexLattice::MAX_SHELL_SITES];
+	for(uint32_t c=0;c<molecules.size();c++){
+		if(molecules[c].getAttributeTag()!=2)
+			continue;
+
+		std::vector<uint32_t> expected;
+		for(uint32_t p=0;p<molecules.size();p++){
+			if(molecules[p].getAttributeTag()!=1)
+				continue;
+			const VectorInt3 diff(minimumImage(molecules[p].getX()-molecules[c].getX(),int32_t(boxX),periodic),
+			                      minimumImage(molecules[p].getY()-molecules[c].getY(),int32_t(boxY),periodic),
+			                      minimumImage(molecules[p].getZ()-molecules[c].getZ(),int32_t(boxZ),periodic));
+			if(diff*diff<=6)
+				expected.push_back(p);
+		}
+
+		found.clear();
+		lattice.collectShell(molecules[c],found);
+		std::sort(found.begin(),found.end());
+		const size_t numFound(lattice.collectShell(molecules[c],buffer));
+		std::sort(buffer,buffer+numFound);
+
+		std::stringstream what;
+		what << "box " << boxX << "x" << boxY << "x" << boxZ << (periodic ? " periodic" : " closed") << " cosolvent " << c;
+		report.check(lattice.countShell(molecules[c])==expected.size(),what.str()+" countShell");
+		report.check(found==expected,what.str()+" collectShell(vector)");
+		report.check(std::vector<uint32_t>(buffer,buffer+numFound)==expected,what.str()+" collectShell(buffer)");
+	}
+}
+
+int main()
+{
+	TestReport report("TestMonomerIndexLattice");
+	std::srand(1);
+
+	for(uint32_t box=1;box<=12;box++){
+		testBox(report,box,box,box,true);
+		testBox(report,box,box,box,false);
+	}
+	testBox(report,1,2,9,true);
+	testBox(report,3,4,5,true);
+	testBox(report,7,2,11,false);
+
+	return report.finish();
+}
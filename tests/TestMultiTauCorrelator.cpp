@@ -0,0 +1,88 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief MultiTauCorrelator against the direct correlation of block averages
+ * @details Level k of the correlator has to see the averages of consecutive
+ * blocks of averaging^k frames, so every lag is compared with the direct
+ * average of the products of these block averages over all time origins
+ * and channels, including the number of time origins.
+ * */
+/*****************************************************************************/
+
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "MultiTauCorrelator.h"
+#include "TestSystem.h"
+
+void testSeries(TestReport& report, size_t numChannels, size_t numLevels, size_t pointsPerLevel, size_t averaging, size_t numFrames)
+{
+	std::stringstream name;
+	name << "channels " << numChannels << " levels " << numLevels << " points " << pointsPerLevel
+	     << " averaging " << averaging << " frames " << numFrames;
+
+	// random walks, so the correlations decay slowly
+	std::vector< std::vector<double> > series(numFrames,std::vector<double>(numChannels));
+	MultiTauCorrelator correlator(numChannels,numLevels,pointsPerLevel,averaging);
+	for(size_t t=0;t<numFrames;t++){
+		for(size_t c=0;c<numChannels;c++)
+			series[t][c]=(t>0 ? 0.9*series[t-1][c] : 0.0)+double(std::rand())/RAND_MAX-0.5;
+		correlator.add(series[t].data());
+	}
+
+	size_t numLags(0);
+	size_t blockSize(1);
+	for(size_t k=0;k<numLevels;k++,blockSize*=averaging){
+		// block averages seen by level k
+		const size_t numBlocks(numFrames/blockSize);
+		std::vector< std::vector<double> > blocks(numBlocks,std::vector<double>(numChannels,0.0));
+		for(size_t b=0;b<numBlocks;b++)
+			for(size_t t=b*blockSize;t<(b+1)*blockSize;t++)
+				for(size_t c=0;c<numChannels;c++)
+					blocks[b][c]+=series[t][c]/double(blockSize);
+
+		for(size_t j=(k==0 ? 0 : pointsPerLevel/averaging);j<pointsPerLevel;j++){
+			if(j>=numBlocks)
+				break;
+			double sum(0.0);
+			for(size_t b=j;b<numBlocks;b++)
+				for(size_t c=0;c<numChannels;c++)
+					sum+=blocks[b][c]*blocks[b-j][c];
+			const uint64_t numOrigins(numBlocks-j);
+			const double expected(sum/(double(numOrigins)*double(numChannels)));
+
+			std::stringstream what;
+			what << name.str() << " lag " << j*blockSize;
+			report.check(correlator.getLag(numLags)==j*blockSize,what.str()+" lag");
+			report.check(correlator.getNumSamples(numLags)==numOrigins,what.str()+" number of time origins");
+			report.check(std::fabs(correlator.getCorrelation(numLags)-expected)<=1e-12*(1.0+std::fabs(expected)),what.str()+" correlation");
+			numLags++;
+		}
+	}
+	report.check(correlator.getNumLags()==numLags,name.str()+" number of lags");
+}
+
+int main()
+{
+	TestReport report("TestMultiTauCorrelator");
+	std::srand(3);
+
+	testSeries(report,1,1,8,2,50);
+	testSeries(report,5,4,16,2,1000);
+	testSeries(report,3,6,8,4,3000);
+	testSeries(report,7,16,16,2,100);
+
+	// invalid parameters are refused
+	bool refused(false);
+	try{
+		MultiTauCorrelator correlator(1,4,6,4);
+	}catch(const std::runtime_error&){
+		refused=true;
+	}
+	report.check(refused,"pointsPerLevel not a multiple of averaging");
+
+	return report.finish();
+}
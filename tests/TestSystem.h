@@ -0,0 +1,124 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Minimal replacement of the LeMonADE ingredients for the tests of the utility headers
+ * @details Provides only what the helpers use: a box with periodicity,
+ * monomers with position and attribute tag and the bond graph. Only
+ * LeMonADE/utility/Vector3D.h (and DistanceCalculation.h through
+ * MoleculeIndex.h) is needed, the LeMonADE library is not linked.
+ * */
+/*****************************************************************************/
+
+#ifndef TEST_SYSTEM_H_
+#define TEST_SYSTEM_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <LeMonADE/utility/Vector3D.h>
+
+class TestMonomer : public VectorInt3
+{
+public:
+	TestMonomer(const VectorInt3& pos=VectorInt3(0,0,0), int32_t tag_=1):VectorInt3(pos),tag(tag_){}
+
+	int32_t getAttributeTag() const {return tag;}
+	void setAttributeTag(int32_t tag_) {tag=tag_;}
+
+private:
+	int32_t tag;
+};
+
+class TestMolecules
+{
+public:
+	size_t size() const {return monomers.size();}
+
+	TestMonomer& operator[](size_t n) {return monomers[n];}
+	const TestMonomer& operator[](size_t n) const {return monomers[n];}
+
+	void addMonomer(const VectorInt3& pos, int32_t tag)
+	{
+		monomers.push_back(TestMonomer(pos,tag));
+		links.push_back(std::vector<uint32_t>());
+	}
+
+	void connect(uint32_t a, uint32_t b)
+	{
+		links[a].push_back(b);
+		links[b].push_back(a);
+	}
+
+	bool areConnected(uint32_t a, uint32_t b) const
+	{
+		for(size_t l=0;l<links[a].size();l++)
+			if(links[a][l]==b)
+				return true;
+		return false;
+	}
+
+	uint32_t getNumLinks(uint32_t n) const {return uint32_t(links[n].size());}
+	uint32_t getNeighborIdx(uint32_t n, uint32_t l) const {return links[n][l];}
+
+private:
+	std::vector<TestMonomer> monomers;
+	std::vector< std::vector<uint32_t> > links;
+};
+
+class TestIngredients
+{
+public:
+	TestIngredients(uint32_t boxX_=32, uint32_t boxY_=32, uint32_t boxZ_=32, bool periodic_=true)
+	{
+		box[0]=boxX_; box[1]=boxY_; box[2]=boxZ_;
+		periodic[0]=periodic[1]=periodic[2]=periodic_;
+	}
+
+	uint32_t getBoxX() const {return box[0];}
+	uint32_t getBoxY() const {return box[1];}
+	uint32_t getBoxZ() const {return box[2];}
+	bool isPeriodicX() const {return periodic[0];}
+	bool isPeriodicY() const {return periodic[1];}
+	bool isPeriodicZ() const {return periodic[2];}
+
+	TestMolecules& modifyMolecules() {return molecules;}
+	const TestMolecules& getMolecules() const {return molecules;}
+
+private:
+	uint32_t box[3];
+	bool periodic[3];
+	TestMolecules molecules;
+};
+
+//! counts the failed checks of a test program
+class TestReport
+{
+public:
+	explicit TestReport(const std::string& name_):name(name_),numChecks(0),numFailures(0){}
+
+	void check(bool condition, const std::string& what)
+	{
+		numChecks++;
+		if(!condition){
+			if(numFailures<20)
+				std::cerr << name << ": FAILED " << what << std::endl;
+			numFailures++;
+		}
+	}
+
+	//! exit code of the test program
+	int finish() const
+	{
+		std::cout << name << ": " << numChecks << " checks, " << numFailures << " failures" << std::endl;
+		return numFailures==0 ? 0 : 1;
+	}
+
+private:
+	std::string name;
+	uint64_t numChecks;
+	uint64_t numFailures;
+};
+
+#endif /* TEST_SYSTEM_H_ */
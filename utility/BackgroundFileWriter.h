@@ -0,0 +1,209 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Append-only output file that is written by a background thread
+ * @details Data passed to write() is collected in blocks in memory. Full blocks
+ * are handed to a writer thread, which appends them to the file and flushes
+ * the stream, so the calling analyzer does not wait for the disk and at most
+ * one block is lost if the program is killed. At most maxPendingBlocks full
+ * blocks are kept in memory; if the disk falls further behind, flush() waits.
+ * With a positive flushInterval, flushIfDue() also hands over an incomplete
+ * block once flushInterval seconds have passed since the last hand-over, which
+ * bounds the data lost by a crash in time for slowly growing files.
+ * */
+/*****************************************************************************/
+
+#ifndef BACKGROUND_FILE_WRITER_H_
+#define BACKGROUND_FILE_WRITER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*****************************************************************************/
+/**
+ * @class BackgroundFileWriter
+ * @brief writes blocks of bytes to a file on an own thread
+ * @details The file is created (or truncated) in the constructor. write()
+ * and flush() must be called from one thread only. A failed write on the
+ * background thread is reported by the next call of write(), flush() or close().
+ * */
+/*****************************************************************************/
+class BackgroundFileWriter
+{
+public:
+	explicit BackgroundFileWriter(const std::string& filename_, size_t blockSize_=size_t(1)<<20, size_t maxPendingBlocks_=8, double flushInterval_=0.0);
+
+	//! closes the file, errors are only reported by an explicit close()
+	~BackgroundFileWriter();
+
+	//! appends numBytes bytes of data, the block is handed to the writer thread when full
+	void write(const void* data, size_t numBytes);
+
+	void write(const std::string& text) {write(text.data(),text.size());}
+
+	//! hands the current block to the writer thread, also if it is not full
+	void flush();
+
+	//! flush() if flushInterval is positive and has passed since the last hand-over, call it at record borders
+	void flushIfDue();
+
+	//! writes all pending blocks and stops the writer thread
+	void close();
+
+	const std::string& getFilename() const {return filename;}
+
+private:
+	std::string filename;
+	std::ofstream file;
+	size_t blockSize;
+	size_t maxPendingBlocks;
+	double flushInterval;
+	std::chrono::steady_clock::time_point lastHandOver;
+
+	//! block that is filled by write()
+	std::vector<char> currentBlock;
+
+	//! full blocks waiting for the writer thread
+	std::deque< std::vector<char> > pendingBlocks;
+
+	std::mutex queueMutex;
+	std::condition_variable queueCondition;
+	std::condition_variable spaceCondition;
+	bool closing;
+	bool failed;
+	std::thread worker;
+
+	void run();
+	void checkState();
+
+	//! hands the current block to the writer thread without checking for errors
+	void queueBlock();
+};
+
+inline BackgroundFileWriter::BackgroundFileWriter(const std::string& filename_, size_t blockSize_, size_t maxPendingBlocks_, double flushInterval_):
+	filename(filename_),
+	file(filename_.c_str(),std::ios::out | std::ios::binary | std::ios::trunc),
+	blockSize(blockSize_ > 0 ? blockSize_ : 1),
+	maxPendingBlocks(maxPendingBlocks_ > 0 ? maxPendingBlocks_ : 1),
+	flushInterval(flushInterval_),
+	lastHandOver(std::chrono::steady_clock::now()),
+	closing(false),
+	failed(false)
+{
+	if(!file)
+		throw std::runtime_error("BackgroundFileWriter: cannot open "+filename);
+	currentBlock.reserve(blockSize);
+	worker=std::thread(&BackgroundFileWriter::run,this);
+}
+
+inline BackgroundFileWriter::~BackgroundFileWriter()
+{
+	try{ close(); }
+	catch(...){}
+}
+
+inline void BackgroundFileWriter::write(const void* data, size_t numBytes)
+{
+	checkState();
+	const char* bytes(static_cast<const char*>(data));
+	currentBlock.insert(currentBlock.end(),bytes,bytes+numBytes);
+	if(currentBlock.size()>=blockSize)
+		flush();
+}
+
+inline void BackgroundFileWriter::flush()
+{
+	checkState();
+	queueBlock();
+}
+
+inline void BackgroundFileWriter::flushIfDue()
+{
+	if(flushInterval <= 0.0)
+		return;
+	const std::chrono::duration<double> sinceHandOver(std::chrono::steady_clock::now()-lastHandOver);
+	if(sinceHandOver.count() >= flushInterval)
+		flush();
+}
+
+inline void BackgroundFileWriter::queueBlock()
+{
+	lastHandOver=std::chrono::steady_clock::now();
+	if(currentBlock.empty())
+		return;
+	{
+		std::unique_lock<std::mutex> lock(queueMutex);
+		spaceCondition.wait(lock,[this](){return pendingBlocks.size()<maxPendingBlocks;});
+		pendingBlocks.push_back(std::vector<char>());
+		pendingBlocks.back().swap(currentBlock);
+	}
+	queueCondition.notify_one();
+	currentBlock.reserve(blockSize);
+}
+
+inline void BackgroundFileWriter::close()
+{
+	if(!worker.joinable())
+		return;
+	// the writer thread is always stopped and joined, a write error is reported afterwards
+	queueBlock();
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		closing=true;
+	}
+	queueCondition.notify_one();
+	worker.join();
+	file.close();
+	if(failed)
+		throw std::runtime_error("BackgroundFileWriter: write error in "+filename);
+}
+
+inline void BackgroundFileWriter::checkState()
+{
+	if(!worker.joinable())
+		throw std::runtime_error("BackgroundFileWriter: "+filename+" is already closed");
+	std::lock_guard<std::mutex> lock(queueMutex);
+	if(failed)
+		throw std::runtime_error("BackgroundFileWriter: write error in "+filename);
+}
+
+/******************************************************************************/
+/**
+ * @fn void BackgroundFileWriter::run()
+ * @brief loop of the writer thread: appends the pending blocks in order until close()
+ */
+inline void BackgroundFileWriter::run()
+{
+	std::unique_lock<std::mutex> lock(queueMutex);
+	while(true){
+		queueCondition.wait(lock,[this](){return closing || !pendingBlocks.empty();});
+		if(pendingBlocks.empty())
+			break;
+
+		std::vector<char> block;
+		block.swap(pendingBlocks.front());
+		pendingBlocks.pop_front();
+		spaceCondition.notify_one();
+
+		// the disk is accessed without the lock, write() can go on meanwhile
+		lock.unlock();
+		bool ok(true);
+		if(!failed){
+			file.write(&block[0],block.size());
+			file.flush();
+			ok=bool(file);
+		}
+		lock.lock();
+		if(!ok)
+			failed=true;
+	}
+}
+
+#endif /* BACKGROUND_FILE_WRITER_H_ */
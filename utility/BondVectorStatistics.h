@@ -0,0 +1,247 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Squared bond lengths and bond vector occupancy from a flat bond list
+ * @details The bonds are collected once as pairs of monomer indices. For every
+ * frame the coordinates of both ends are gathered from arrays x, y, z and the
+ * bond vectors and the sum of their squared lengths are computed in blocks
+ * (AVX2 gather and 64 bit integer reduction, or plain scalar code). The bond
+ * vectors of each block are sorted into a histogram over the 108 bond vectors
+ * of the bond fluctuation model with a 7x7x7 lookup table; everything else
+ * (e.g. bonds across a periodic border of raw coordinates) is counted as other.
+ * All sums are exact integers and kept in BondVectorStatistics::Sums, so
+ * frames can be evaluated on several threads and merged in any order.
+ * */
+/*****************************************************************************/
+
+#ifndef BOND_VECTOR_STATISTICS_H_
+#define BOND_VECTOR_STATISTICS_H_
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include <stdint.h>
+
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "CpuFeatures.h"
+
+/*****************************************************************************/
+/**
+ * @class BondVectorStatistics
+ * @brief bond list of the first frame and the kernel that sums over its bond vectors
+ * */
+/*****************************************************************************/
+class BondVectorStatistics
+{
+public:
+	enum {NUM_BOND_VECTORS=108};
+
+	//! mergeable sums over the bond vectors of a number of frames
+	class Sums
+	{
+	public:
+		Sums() {clear();}
+
+		void clear()
+		{
+			std::fill(counts,counts+NUM_BOND_VECTORS,uint64_t(0));
+			numOther=0;
+			numSamples=0;
+			sumSquaredLength=0;
+		}
+
+		void merge(const Sums& other)
+		{
+			for(size_t id=0;id<NUM_BOND_VECTORS;id++)
+				counts[id]+=other.counts[id];
+			numOther+=other.numOther;
+			numSamples+=other.numSamples;
+			sumSquaredLength+=other.sumSquaredLength;
+		}
+
+		//! number of bond samples (bonds times frames)
+		uint64_t getNumSamples() const {return numSamples;}
+
+		//! exact sum of the squared bond lengths of all samples
+		int64_t getSumSquaredLength() const {return sumSquaredLength;}
+
+		double getMeanSquaredLength() const {return numSamples>0 ? double(sumSquaredLength)/double(numSamples) : 0.0;}
+
+		//! occurrences of bond vector id (0 <= id < NUM_BOND_VECTORS)
+		uint64_t getCount(size_t id) const {return counts[id];}
+
+		//! samples that are not one of the 108 bond vectors
+		uint64_t getNumOther() const {return numOther;}
+
+	private:
+		friend class BondVectorStatistics;
+
+		uint64_t counts[NUM_BOND_VECTORS];
+		uint64_t numOther;
+		uint64_t numSamples;
+		int64_t sumSquaredLength;
+	};
+
+	//! collects every bond once (lower index first), the topology must not change afterwards
+	template<class MoleculesType>
+	void build(const MoleculesType& molecules);
+
+	//! adds the bonds of one frame to sums, x, y, z are the coordinates of all monomers
+	void addFrame(const int32_t* x, const int32_t* y, const int32_t* z, Sums& sums) const;
+
+	size_t getNumBonds() const {return first.size();}
+
+	//! bond vector with index id, ordered lexicographically by x, y, z
+	static VectorInt3 getBondVector(size_t id);
+
+private:
+	//! bonds of at most this many samples are processed at once
+	static const size_t blockSize=256;
+
+	std::vector<int32_t> first;
+	std::vector<int32_t> second;
+
+	//! bond vector id of (dx+3, dy+3, dz+3) or -1
+	static const int8_t* getLookupTable();
+
+	static int64_t bondDifferencesScalar(const int32_t* x, const int32_t* y, const int32_t* z,
+	                                     const int32_t* first, const int32_t* second, size_t n,
+	                                     int32_t* dx, int32_t* dy, int32_t* dz);
+#ifdef CPU_FEATURES_X86
+	static int64_t bondDifferencesAVX2(const int32_t* x, const int32_t* y, const int32_t* z,
+	                                   const int32_t* first, const int32_t* second, size_t n,
+	                                   int32_t* dx, int32_t* dy, int32_t* dz);
+#endif
+};
+
+template<class MoleculesType>
+void BondVectorStatistics::build(const MoleculesType& molecules)
+{
+	first.clear();
+	second.clear();
+	for(size_t k=0;k<molecules.size();k++){
+		for(size_t l=0;l<molecules.getNumLinks(k);l++){
+			const size_t neighbor(molecules.getNeighborIdx(k,l));
+			if(k<neighbor){
+				first.push_back(int32_t(k));
+				second.push_back(int32_t(neighbor));
+			}
+		}
+	}
+}
+
+inline void BondVectorStatistics::addFrame(const int32_t* x, const int32_t* y, const int32_t* z, Sums& sums) const
+{
+	const int8_t* lookup(getLookupTable());
+	int32_t dx[blockSize], dy[blockSize], dz[blockSize];
+	for(size_t start=0;start<first.size();start+=blockSize){
+		const size_t n(std::min(blockSize,first.size()-start));
+#ifdef CPU_FEATURES_X86
+		if(CpuFeatures::getInstructionSet()==CpuFeatures::AVX2)
+			sums.sumSquaredLength+=bondDifferencesAVX2(x,y,z,&first[start],&second[start],n,dx,dy,dz);
+		else
+#endif
+			sums.sumSquaredLength+=bondDifferencesScalar(x,y,z,&first[start],&second[start],n,dx,dy,dz);
+
+		for(size_t b=0;b<n;b++){
+			if(std::abs(dx[b])<=3 && std::abs(dy[b])<=3 && std::abs(dz[b])<=3){
+				const int8_t id(lookup[(dx[b]+3)*49+(dy[b]+3)*7+(dz[b]+3)]);
+				if(id>=0){
+					sums.counts[id]++;
+					continue;
+				}
+			}
+			sums.numOther++;
+		}
+	}
+	sums.numSamples+=first.size();
+}
+
+/******************************************************************************/
+/**
+ * @fn const int8_t* BondVectorStatistics::getLookupTable()
+ * @brief 7x7x7 table of the bond vector ids, built on first use
+ * @details The bond vectors are all permutations and sign changes of
+ * (2,0,0), (2,1,0), (2,1,1), (2,2,1), (3,0,0) and (3,1,0).
+ */
+inline const int8_t* BondVectorStatistics::getLookupTable()
+{
+	struct Table {
+		int8_t id[343];
+		Table()
+		{
+			int8_t next(0);
+			for(int x=-3;x<=3;x++)
+				for(int y=-3;y<=3;y++)
+					for(int z=-3;z<=3;z++){
+						int a[3]={std::abs(x),std::abs(y),std::abs(z)};
+						std::sort(a,a+3);
+						// sorted absolute values 0,0,2 / 0,1,2 / 1,1,2 / 1,2,2 / 0,0,3 / 0,1,3
+						const bool isBond((a[2]==2 && a[1]<=1) || (a[2]==2 && a[1]==2 && a[0]==1) || (a[2]==3 && a[1]==0) || (a[2]==3 && a[1]==1 && a[0]==0));
+						id[(x+3)*49+(y+3)*7+(z+3)]=isBond ? next++ : int8_t(-1);
+					}
+		}
+	};
+	static const Table table;
+	return table.id;
+}
+
+inline VectorInt3 BondVectorStatistics::getBondVector(size_t id)
+{
+	const int8_t* lookup(getLookupTable());
+	for(int i=0;i<343;i++)
+		if(lookup[i]==int8_t(id))
+			return VectorInt3(i/49-3,(i/7)%7-3,i%7-3);
+	return VectorInt3(0,0,0);
+}
+
+inline int64_t BondVectorStatistics::bondDifferencesScalar(const int32_t* x, const int32_t* y, const int32_t* z,
+                                                           const int32_t* first, const int32_t* second, size_t n,
+                                                           int32_t* dx, int32_t* dy, int32_t* dz)
+{
+	int64_t sum(0);
+	for(size_t b=0;b<n;b++){
+		dx[b]=x[second[b]]-x[first[b]];
+		dy[b]=y[second[b]]-y[first[b]];
+		dz[b]=z[second[b]]-z[first[b]];
+		sum+=int64_t(dx[b])*dx[b]+int64_t(dy[b])*dy[b]+int64_t(dz[b])*dz[b];
+	}
+	return sum;
+}
+
+#ifdef CPU_FEATURES_X86
+/******************************************************************************/
+/**
+ * @fn int64_t BondVectorStatistics::bondDifferencesAVX2()
+ * @brief gathers the ends of 8 bonds at once, squares are summed in four 64 bit lanes
+ */
+__attribute__((target("avx2")))
+inline int64_t BondVectorStatistics::bondDifferencesAVX2(const int32_t* x, const int32_t* y, const int32_t* z,
+                                                         const int32_t* first, const int32_t* second, size_t n,
+                                                         int32_t* dx, int32_t* dy, int32_t* dz)
+{
+	__m256i sum=_mm256_setzero_si256();
+	size_t b(0);
+	for(;b+8<=n;b+=8){
+		const __m256i i=_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first+b));
+		const __m256i j=_mm256_loadu_si256(reinterpret_cast<const __m256i*>(second+b));
+		const int32_t* coordinates[3]={x,y,z};
+		int32_t* differences[3]={dx,dy,dz};
+		for(int a=0;a<3;a++){
+			const int* c(reinterpret_cast<const int*>(coordinates[a]));
+			const __m256i d=_mm256_sub_epi32(_mm256_i32gather_epi32(c,j,4),_mm256_i32gather_epi32(c,i,4));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(differences[a]+b),d);
+			// signed 32x32->64 bit products of the even and the odd lanes
+			sum=_mm256_add_epi64(sum,_mm256_mul_epi32(d,d));
+			const __m256i odd=_mm256_srli_epi64(d,32);
+			sum=_mm256_add_epi64(sum,_mm256_mul_epi32(odd,odd));
+		}
+	}
+	int64_t lanes[4];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes),sum);
+	return lanes[0]+lanes[1]+lanes[2]+lanes[3]+bondDifferencesScalar(x,y,z,first+b,second+b,n-b,dx+b,dy+b,dz+b);
+}
+#endif
+
+#endif /* BOND_VECTOR_STATISTICS_H_ */
@@ -0,0 +1,304 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Classification of the contacts of a cosolvent as intra- or inter-chain bridge
+ * @details The chains are the molecules of the bond graph (see MoleculeIndex).
+ * The contour distance of two contacts on one chain is the number of bonds on
+ * the shortest path between them. For linear chains it is the difference of
+ * the positions along the chain, for rings the shorter way around the ring and
+ * for branched molecules (trees) the path through the lowest common ancestor
+ * in a breadth first search tree. The ancestors at distances 2^j of every
+ * monomer of a branched chain are tabulated in build() (binary lifting), so
+ * a lowest common ancestor costs O(log depth) instead of a walk up the tree.
+ * The tables are built once, so a classification does not depend on the
+ * number of chains: the at most MAX_CONTACTS contacts are sorted by chain in
+ * a buffer on the stack and the contacts of every chain are compared with
+ * each other, at most MAX_CONTACTS^2/2 lookups per cosolvent.
+ * Molecules with cycles that are not simple rings (networks) only get the
+ * distance along their breadth first search tree, which is an upper bound of
+ * the shortest path; their number is reported by getNumNetworkChains().
+ * */
+/*****************************************************************************/
+
+#ifndef CHAIN_BRIDGE_ENGINE_H_
+#define CHAIN_BRIDGE_ENGINE_H_
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <stdint.h>
+
+#include "MoleculeIndex.h"
+#include "MonomerIndexLattice.h"
+
+/*****************************************************************************/
+/**
+ * @class ChainBridgeEngine
+ * @brief monomer -> (chain, contour position) table and the bridge criterion
+ * @details A cosolvent is an intra-chain bridge if two of its contacts on the
+ * same chain are at least minContourSpan bonds apart along the contour, and an
+ * inter-chain bridge if its contacts belong to at least two chains.
+ * */
+/*****************************************************************************/
+class ChainBridgeEngine
+{
+public:
+	//! largest number of contacts, one per site of the NN-shell
+	enum {MAX_CONTACTS=MonomerIndexLattice::MAX_SHELL_SITES};
+
+	//! topology of a chain, decides how contour distances are measured
+	enum ChainShape {LINEAR=0, RING=1, BRANCHED=2, NETWORK=3};
+
+	struct Bridge
+	{
+		uint32_t numContacts;
+		uint32_t numChains;
+		//! largest contour distance of two contacts on the same chain
+		uint32_t maxContourSpan;
+		bool isIntraChain;
+		bool isInterChain;
+
+		bool isBridge() const {return isIntraChain || isInterChain;}
+	};
+
+	explicit ChainBridgeEngine(uint32_t minContourSpan_=5):minContourSpan(minContourSpan_),maxContourSpan(0),numNetworkChains(0),numAncestorLevels(0){}
+
+	//! builds the tables from the bonds, changes of the bonds require a new call
+	template<class MoleculesType>
+	void build(const MoleculesType& molecules);
+
+	//! classifies the contacts (monomer indices) of one cosolvent, numContacts <= MAX_CONTACTS
+	Bridge classify(const uint32_t* contacts, size_t numContacts) const;
+
+	//! number of bonds on the shortest path between two monomers of the same chain
+	uint32_t getContourDistance(uint32_t monomerA, uint32_t monomerB) const;
+
+	uint32_t getChain(uint32_t monomer) const {return uint32_t(chainContour[monomer]>>32);}
+	//! position along a linear chain or ring, depth in the breadth first search tree otherwise
+	uint32_t getContourPosition(uint32_t monomer) const {return uint32_t(chainContour[monomer]);}
+	ChainShape getChainShape(uint32_t chain) const {return ChainShape(chainShape[chain]);}
+	size_t getNumChains() const {return moleculeIndex.getNumMolecules();}
+
+	//! upper bound of every contour distance, bound of every contour span
+	uint32_t getMaxContourSpan() const {return maxContourSpan;}
+
+	//! number of chains with cycles that are not simple rings
+	size_t getNumNetworkChains() const {return numNetworkChains;}
+
+	uint32_t getMinContourSpan() const {return minContourSpan;}
+
+private:
+	uint32_t minContourSpan;
+
+	uint32_t maxContourSpan;
+
+	size_t numNetworkChains;
+
+	MoleculeIndex moleculeIndex;
+
+	//! chain in the upper and contour position in the lower 32 bit, sorts by chain first
+	std::vector<uint64_t> chainContour;
+
+	//! predecessor in the breadth first search tree, the root is its own parent
+	std::vector<uint32_t> parent;
+
+	//! ancestors at distance 2^(j+1) of all monomers at [j*size,(j+1)*size), only for branched chains and networks
+	std::vector<uint32_t> ancestors;
+	uint32_t numAncestorLevels;
+
+	//! ancestor at distance 2^level, level 0 is the parent
+	uint32_t getAncestor(uint32_t level, uint32_t monomer) const
+	{
+		return (level==0) ? parent[monomer] : ancestors[size_t(level-1)*parent.size()+monomer];
+	}
+
+	//! ChainShape of every chain
+	std::vector<uint8_t> chainShape;
+};
+
+/******************************************************************************/
+/**
+ * @fn void ChainBridgeEngine::build(const MoleculesType& molecules)
+ * @brief classifies the shape of every molecule and numbers its monomers along the contour
+ * @details Linear chains and trees are searched breadth first from the chain
+ * end with the lowest index, so on a linear chain the depth is the position
+ * along the chain. Rings are walked once around from their lowest index.
+ * For branched chains and networks the ancestor tables of the breadth first
+ * search trees are filled level by level afterwards.
+ */
+template<class MoleculesType>
+void ChainBridgeEngine::build(const MoleculesType& molecules)
+{
+	moleculeIndex.build(molecules);
+
+	const uint32_t unassigned(uint32_t(-1));
+	std::vector<uint32_t> depth(molecules.size(),unassigned);
+	std::vector<uint32_t> queue;
+	chainContour.assign(molecules.size(),0);
+	parent.assign(molecules.size(),0);
+	chainShape.assign(moleculeIndex.getNumMolecules(),uint8_t(LINEAR));
+	maxContourSpan=0;
+	numNetworkChains=0;
+	uint32_t maxTreeDepth(0);
+
+	for(size_t m=0;m<moleculeIndex.getNumMolecules();m++){
+		const uint32_t* monomers(moleculeIndex.getMonomers(m));
+		const size_t size(moleculeIndex.getMoleculeSize(m));
+
+		// a connected molecule is a tree if it has size-1 bonds
+		uint32_t start(unassigned);
+		uint64_t numLinks(0);
+		uint32_t maxLinks(0);
+		for(size_t k=0;k<size;k++){
+			const uint32_t links(molecules.getNumLinks(monomers[k]));
+			numLinks+=links;
+			maxLinks=std::max(maxLinks,links);
+			if(links<=1 && monomers[k]<start)
+				start=monomers[k];
+		}
+		const bool cyclic(numLinks/2>=size);
+
+		ChainShape shape(LINEAR);
+		if(cyclic)
+			shape=(maxLinks==2 && numLinks==2*size) ? RING : NETWORK;
+		else if(maxLinks>2)
+			shape=BRANCHED;
+		chainShape[m]=uint8_t(shape);
+		if(shape==NETWORK)
+			numNetworkChains++;
+
+		if(shape==RING){
+			// walk once around the ring, the position is the number of steps from the lowest index
+			uint32_t previous(unassigned), current(*std::min_element(monomers,monomers+size));
+			for(uint32_t position=0;position<size;position++){
+				chainContour[current]=(uint64_t(m)<<32) | uint64_t(position);
+				parent[current]=(previous==unassigned) ? current : previous;
+				uint32_t next(molecules.getNeighborIdx(current,0));
+				if(next==previous)
+					next=molecules.getNeighborIdx(current,1);
+				previous=current;
+				current=next;
+			}
+			maxContourSpan=std::max(maxContourSpan,uint32_t(size/2));
+			continue;
+		}
+
+		if(start==unassigned)
+			start=monomers[0];
+
+		uint32_t maxDepth(0);
+		queue.assign(1,start);
+		depth[start]=0;
+		parent[start]=start;
+		for(size_t q=0;q<queue.size();q++){
+			const uint32_t current(queue[q]);
+			chainContour[current]=(uint64_t(m)<<32) | uint64_t(depth[current]);
+			maxDepth=std::max(maxDepth,depth[current]);
+			for(uint32_t l=0;l<molecules.getNumLinks(current);l++){
+				const uint32_t neighbor(molecules.getNeighborIdx(current,l));
+				if(depth[neighbor]!=unassigned)
+					continue;
+				depth[neighbor]=depth[current]+1;
+				parent[neighbor]=current;
+				queue.push_back(neighbor);
+			}
+		}
+		// two branches can each reach down to the largest depth
+		maxContourSpan=std::max(maxContourSpan,(shape==LINEAR) ? maxDepth : 2*maxDepth);
+		if(shape!=LINEAR)
+			maxTreeDepth=std::max(maxTreeDepth,maxDepth);
+	}
+
+	// binary lifting: the ancestor at 2^j is the ancestor at 2^(j-1) of the ancestor at 2^(j-1)
+	numAncestorLevels=1;
+	while(numAncestorLevels<32 && (uint64_t(1)<<numAncestorLevels)<=maxTreeDepth)
+		numAncestorLevels++;
+	const size_t numMonomers(molecules.size());
+	ancestors.assign(size_t(numAncestorLevels-1)*numMonomers,0);
+	for(uint32_t level=1;level<numAncestorLevels;level++){
+		uint32_t* row(&ancestors[size_t(level-1)*numMonomers]);
+		for(size_t i=0;i<numMonomers;i++)
+			row[i]=getAncestor(level-1,getAncestor(level-1,uint32_t(i)));
+	}
+}
+
+inline uint32_t ChainBridgeEngine::getContourDistance(uint32_t monomerA, uint32_t monomerB) const
+{
+	const uint32_t chain(getChain(monomerA));
+	if(getChain(monomerB)!=chain)
+		throw std::runtime_error("ChainBridgeEngine::getContourDistance: monomers on different chains");
+
+	uint32_t depthA(getContourPosition(monomerA)), depthB(getContourPosition(monomerB));
+	const uint32_t difference((depthA>depthB) ? depthA-depthB : depthB-depthA);
+
+	switch(chainShape[chain]){
+	case LINEAR:
+		return difference;
+	case RING:
+		return std::min(difference,uint32_t(moleculeIndex.getMoleculeSize(chain))-difference);
+	default:
+		break;
+	}
+
+	// lift the deeper monomer to the depth of the other one
+	if(depthA<depthB){
+		std::swap(monomerA,monomerB);
+		std::swap(depthA,depthB);
+	}
+	for(uint32_t level=0;level<numAncestorLevels;level++)
+		if((difference>>level) & 1u)
+			monomerA=getAncestor(level,monomerA);
+	if(monomerA==monomerB)
+		return difference;
+
+	// lift both to just below the lowest common ancestor
+	for(uint32_t level=numAncestorLevels;level-->0;){
+		const uint32_t ancestorA(getAncestor(level,monomerA)), ancestorB(getAncestor(level,monomerB));
+		if(ancestorA!=ancestorB){
+			monomerA=ancestorA;
+			monomerB=ancestorB;
+		}
+	}
+	const uint32_t depthCommon(getContourPosition(parent[monomerA]));
+	return difference+2*(depthB-depthCommon);
+}
+
+inline ChainBridgeEngine::Bridge ChainBridgeEngine::classify(const uint32_t* contacts, size_t numContacts) const
+{
+	if(numContacts>MAX_CONTACTS)
+		throw std::runtime_error("ChainBridgeEngine::classify: more contacts than sites in the NN-shell");
+
+	// sorted by chain and contour position
+	uint32_t sorted[MAX_CONTACTS];
+	std::copy(contacts,contacts+numContacts,sorted);
+	std::sort(sorted,sorted+numContacts,[this](uint32_t a, uint32_t b){return chainContour[a]<chainContour[b];});
+
+	Bridge bridge;
+	bridge.numContacts=uint32_t(numContacts);
+	bridge.numChains=0;
+	bridge.maxContourSpan=0;
+
+	// runs of equal chain
+	for(size_t first=0;first<numContacts;){
+		const uint32_t chain(getChain(sorted[first]));
+		size_t last(first);
+		while(last+1<numContacts && getChain(sorted[last+1])==chain)
+			last++;
+		bridge.numChains++;
+
+		if(chainShape[chain]==LINEAR){
+			bridge.maxContourSpan=std::max(bridge.maxContourSpan,getContourPosition(sorted[last])-getContourPosition(sorted[first]));
+		}else{
+			for(size_t a=first;a<last;a++)
+				for(size_t b=a+1;b<=last;b++)
+					bridge.maxContourSpan=std::max(bridge.maxContourSpan,getContourDistance(sorted[a],sorted[b]));
+		}
+		first=last+1;
+	}
+
+	bridge.isIntraChain=numContacts>1 && bridge.maxContourSpan>=minContourSpan;
+	bridge.isInterChain=bridge.numChains>1;
+	return bridge;
+}
+
+#endif /* CHAIN_BRIDGE_ENGINE_H_ */
@@ -0,0 +1,80 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Streams a time series with a fixed number of columns to disk
+ * @details One row is written per call of writeRow(). The rows go through a
+ * BackgroundFileWriter in blocks, so the memory does not grow with the length
+ * of the series. In text mode the file has the comment lines of the header
+ * prefixed by "# " and one tab separated row per line. In binary mode it has
+ *   char[8]  "COLSERIE"
+ *   uint32   version (1)
+ *   uint32   number of columns C
+ * followed by C doubles per row in the byte order of the writing machine.
+ * */
+/*****************************************************************************/
+
+#ifndef COLUMN_SERIES_WRITER_H_
+#define COLUMN_SERIES_WRITER_H_
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <stdint.h>
+
+#include "BackgroundFileWriter.h"
+
+class ColumnSeriesWriter
+{
+public:
+	/**
+	 * @param header comment lines (text mode only), separated by newlines
+	 * @param binary_ binary instead of text rows
+	 */
+	ColumnSeriesWriter(const std::string& filename, uint32_t numColumns_, bool binary_, const std::string& header);
+
+	//! appends one row of numColumns values
+	void writeRow(const double* values);
+
+	//! writes all rows to disk and closes the file
+	void close() {writer.close();}
+
+	const std::string& getFilename() const {return writer.getFilename();}
+
+private:
+	BackgroundFileWriter writer;
+	uint32_t numColumns;
+	bool binary;
+	std::ostringstream line;
+};
+
+inline ColumnSeriesWriter::ColumnSeriesWriter(const std::string& filename, uint32_t numColumns_, bool binary_, const std::string& header):
+	writer(filename), numColumns(numColumns_), binary(binary_)
+{
+	if(binary){
+		const char magic[8]={'C','O','L','S','E','R','I','E'};
+		const uint32_t version(1);
+		writer.write(magic,sizeof(magic));
+		writer.write(&version,sizeof(version));
+		writer.write(&numColumns,sizeof(numColumns));
+	}else{
+		std::istringstream lines(header);
+		std::string comment;
+		while(std::getline(lines,comment))
+			writer.write("# "+comment+"\n");
+	}
+}
+
+inline void ColumnSeriesWriter::writeRow(const double* values)
+{
+	if(binary){
+		writer.write(values,numColumns*sizeof(double));
+		return;
+	}
+	line.str("");
+	for(uint32_t c=0;c<numColumns;c++)
+		line << values[c] << "\t";
+	line << "\n";
+	writer.write(line.str());
+}
+
+#endif /* COLUMN_SERIES_WRITER_H_ */
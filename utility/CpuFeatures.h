@@ -0,0 +1,57 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Runtime detection of the SIMD instruction set of the executing cpu
+ * @details CPU_FEATURES_X86 is defined if the compiler can emit x86 SIMD code
+ * (GCC or clang on x86), and the kernels compile their SSE2/AVX2 variants
+ * only then. getInstructionSet() returns the best supported instruction set,
+ * detected once on first use, so a binary built for generic x86-64 still
+ * dispatches to AVX2 where available.
+ * */
+/*****************************************************************************/
+
+#ifndef CPU_FEATURES_H_
+#define CPU_FEATURES_H_
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
+namespace CpuFeatures
+{
+	//! instruction sets the kernels dispatch to
+	enum InstructionSet {SCALAR=0, SSE2=1, AVX2=2};
+
+	//! best instruction set available on the executing cpu
+	inline InstructionSet detectInstructionSet()
+	{
+#ifdef CPU_FEATURES_X86
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx2"))
+			return AVX2;
+		if(__builtin_cpu_supports("sse2"))
+			return SSE2;
+#endif
+		return SCALAR;
+	}
+
+	//! instruction set used by the kernels, detected on first use
+	inline InstructionSet getInstructionSet()
+	{
+		static const InstructionSet instructionSet(detectInstructionSet());
+		return instructionSet;
+	}
+
+	inline const char* getInstructionSetName()
+	{
+		switch(getInstructionSet())
+		{
+			case AVX2: return "AVX2";
+			case SSE2: return "SSE2";
+			default: return "scalar";
+		}
+	}
+}
+
+#endif /* CPU_FEATURES_H_ */
@@ -0,0 +1,227 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Self-contained complex fast Fourier transform in one and three dimensions
+ * @details Lengths that are a power of two use an iterative radix-2 transform.
+ * All other lengths are mapped onto a radix-2 convolution (Bluestein's
+ * algorithm), so every box size is transformed in O(n log n).
+ * Only the forward transform X_k = SUM_j x_j exp(-2 pi i j k/n) is provided.
+ * */
+/*****************************************************************************/
+
+#ifndef FAST_FOURIER_TRANSFORM_H_
+#define FAST_FOURIER_TRANSFORM_H_
+
+#include <cmath>
+#include <complex>
+#include <vector>
+#include <stdexcept>
+#include <stdint.h>
+
+/*****************************************************************************/
+/**
+ * @class FastFourierTransform
+ * @brief forward discrete Fourier transform of a fixed length
+ * @details The twiddle factors are set up in the constructor. The transform
+ * uses an internal work buffer, so one object must not be shared between threads.
+ * */
+/*****************************************************************************/
+class FastFourierTransform
+{
+public:
+	typedef std::complex<double> complex_type;
+
+	explicit FastFourierTransform(size_t length_);
+
+	//! in-place transform of the contiguous array data[0..length-1]
+	void transform(complex_type* data) const;
+
+	//! in-place transform of the strided line data[0], data[stride], ...
+	void transform(complex_type* data, size_t stride) const;
+
+	size_t getLength() const {return length;}
+
+private:
+	//! length of the transform
+	size_t length;
+
+	//! length of the radix-2 transform (length itself or the Bluestein padding)
+	size_t radix2Length;
+
+	//! exp(-2 pi i k/radix2Length) for k < radix2Length/2
+	std::vector<complex_type> twiddles;
+
+	//! bit reversed index for the radix-2 transform
+	std::vector<uint32_t> bitReversed;
+
+	//! Bluestein chirp exp(-i pi k^2/length)
+	std::vector<complex_type> chirp;
+
+	//! radix-2 transform of the conjugated chirp sequence
+	std::vector<complex_type> chirpKernel;
+
+	mutable std::vector<complex_type> buffer;
+	mutable std::vector<complex_type> line;
+
+	void transformRadix2(complex_type* data) const;
+
+	static bool isPowerOfTwo(size_t n) {return n>0 && (n&(n-1))==0;}
+};
+
+/******************************************************************************/
+/**
+ * @fn FastFourierTransform::FastFourierTransform(size_t length_)
+ * @brief precalculates twiddle factors and, for lengths other than powers of two, the Bluestein chirp
+ */
+inline FastFourierTransform::FastFourierTransform(size_t length_):
+	length(length_), radix2Length(length_)
+{
+	if(length==0)
+		throw std::runtime_error("FastFourierTransform: length must be greater than 0");
+
+	if(!isPowerOfTwo(length)){
+		radix2Length=1;
+		while(radix2Length<2*length-1)
+			radix2Length*=2;
+	}
+
+	twiddles.resize(radix2Length/2);
+	for(size_t k=0;k<twiddles.size();k++)
+		twiddles[k]=std::polar(1.0,-2.0*M_PI*double(k)/double(radix2Length));
+
+	uint32_t numBits(0);
+	while((size_t(1)<<numBits)<radix2Length)
+		numBits++;
+	bitReversed.resize(radix2Length);
+	for(size_t k=0;k<radix2Length;k++){
+		uint32_t reversed(0);
+		for(uint32_t b=0;b<numBits;b++)
+			if(k&(size_t(1)<<b))
+				reversed|=(1u<<(numBits-1-b));
+		bitReversed[k]=reversed;
+	}
+
+	if(radix2Length!=length){
+		// k^2 is reduced modulo 2*length to keep the argument of the chirp small
+		chirp.resize(length);
+		for(size_t k=0;k<length;k++){
+			uint64_t k2((uint64_t(k)*uint64_t(k))%(2*uint64_t(length)));
+			chirp[k]=std::polar(1.0,-M_PI*double(k2)/double(length));
+		}
+		chirpKernel.assign(radix2Length,complex_type(0.0,0.0));
+		chirpKernel[0]=std::conj(chirp[0]);
+		for(size_t k=1;k<length;k++){
+			chirpKernel[k]=std::conj(chirp[k]);
+			chirpKernel[radix2Length-k]=std::conj(chirp[k]);
+		}
+		transformRadix2(&chirpKernel[0]);
+		buffer.resize(radix2Length);
+	}
+	line.resize(length);
+}
+
+/******************************************************************************/
+/**
+ * @fn void FastFourierTransform::transformRadix2(complex_type* data) const
+ * @brief iterative in-place radix-2 transform of length radix2Length
+ */
+inline void FastFourierTransform::transformRadix2(complex_type* data) const
+{
+	for(size_t k=0;k<radix2Length;k++)
+		if(k<bitReversed[k])
+			std::swap(data[k],data[bitReversed[k]]);
+
+	for(size_t half=1;half<radix2Length;half*=2){
+		size_t twiddleStep(radix2Length/(2*half));
+		for(size_t start=0;start<radix2Length;start+=2*half){
+			for(size_t k=0;k<half;k++){
+				complex_type t(twiddles[k*twiddleStep]*data[start+k+half]);
+				data[start+k+half]=data[start+k]-t;
+				data[start+k]+=t;
+			}
+		}
+	}
+}
+
+inline void FastFourierTransform::transform(complex_type* data) const
+{
+	if(radix2Length==length){
+		transformRadix2(data);
+		return;
+	}
+
+	// Bluestein: X_k = chirp_k * SUM_j (x_j chirp_j) conj(chirp_(k-j))
+	for(size_t k=0;k<length;k++)
+		buffer[k]=data[k]*chirp[k];
+	for(size_t k=length;k<radix2Length;k++)
+		buffer[k]=complex_type(0.0,0.0);
+
+	transformRadix2(&buffer[0]);
+	// the inverse transform of the product is done by conjugation
+	for(size_t k=0;k<radix2Length;k++)
+		buffer[k]=std::conj(buffer[k]*chirpKernel[k]);
+	transformRadix2(&buffer[0]);
+
+	const double norm(1.0/double(radix2Length));
+	for(size_t k=0;k<length;k++)
+		data[k]=chirp[k]*std::conj(buffer[k])*norm;
+}
+
+inline void FastFourierTransform::transform(complex_type* data, size_t stride) const
+{
+	if(stride==1){
+		transform(data);
+		return;
+	}
+	for(size_t k=0;k<length;k++)
+		line[k]=data[k*stride];
+	transform(&line[0]);
+	for(size_t k=0;k<length;k++)
+		data[k*stride]=line[k];
+}
+
+/*****************************************************************************/
+/**
+ * @class FastFourierTransform3D
+ * @brief forward transform of a grid stored as grid[x + nx*(y + ny*z)]
+ * @details Holds the transforms along the three axes, so the twiddle factors
+ * and Bluestein chirps are set up once for a box and reused by every call of
+ * transform(). Like FastFourierTransform it must not be shared between threads.
+ * */
+/*****************************************************************************/
+class FastFourierTransform3D
+{
+public:
+	FastFourierTransform3D(size_t nx=1, size_t ny=1, size_t nz=1):fftX(nx),fftY(ny),fftZ(nz){}
+
+	//! in-place transform of grid, which has nx*ny*nz entries
+	void transform(std::vector<FastFourierTransform::complex_type>& grid) const;
+
+	size_t getNumCells() const {return fftX.getLength()*fftY.getLength()*fftZ.getLength();}
+
+private:
+	FastFourierTransform fftX;
+	FastFourierTransform fftY;
+	FastFourierTransform fftZ;
+};
+
+inline void FastFourierTransform3D::transform(std::vector<FastFourierTransform::complex_type>& grid) const
+{
+	const size_t nx(fftX.getLength()), ny(fftY.getLength()), nz(fftZ.getLength());
+	if(grid.size()!=nx*ny*nz)
+		throw std::runtime_error("FastFourierTransform3D: grid size does not match the dimensions");
+
+	for(size_t z=0;z<nz;z++)
+		for(size_t y=0;y<ny;y++)
+			fftX.transform(&grid[nx*(y+ny*z)]);
+
+	for(size_t z=0;z<nz;z++)
+		for(size_t x=0;x<nx;x++)
+			fftY.transform(&grid[x+nx*ny*z],nx);
+
+	for(size_t y=0;y<ny;y++)
+		for(size_t x=0;x<nx;x++)
+			fftZ.transform(&grid[x+nx*y],nx*ny);
+}
+
+#endif /* FAST_FOURIER_TRANSFORM_H_ */
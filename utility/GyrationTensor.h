@@ -0,0 +1,196 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Gyration tensor from integer coordinate moments and its shape descriptors
+ * @details GyrationMoments sums the first and second moments of lattice
+ * coordinates in 64 bit integers. N^2 times the gyration tensor follows
+ * exactly as N SUM r_a r_b - SUM r_a SUM r_b, which equals the pair sum
+ * SUM_(k<l) (r_k - r_l)_a (r_k - r_l)_b. GyrationTensor diagonalises the
+ * symmetric 3x3 tensor in closed form.
+ * */
+/*****************************************************************************/
+
+#ifndef GYRATION_TENSOR_H_
+#define GYRATION_TENSOR_H_
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <stdint.h>
+
+/*****************************************************************************/
+/**
+ * @class GyrationMoments
+ * @brief mergeable sums of the coordinates and their products relative to an origin
+ * @details The coordinates are taken relative to origin to keep the sums
+ * small. The result is exact as long as N^2 times the squared extension of
+ * the structure stays below 9.2e18. Moments of parts of a structure, e.g.
+ * summed on different threads, can be merged if they use the same origin.
+ * Tensor components are ordered xx, yy, zz, xy, xz, yz.
+ * */
+/*****************************************************************************/
+class GyrationMoments
+{
+public:
+	GyrationMoments(int64_t originX_=0, int64_t originY_=0, int64_t originZ_=0)
+	{
+		origin[0]=originX_;
+		origin[1]=originY_;
+		origin[2]=originZ_;
+		clear();
+	}
+
+	void clear()
+	{
+		n=0;
+		std::fill(sum,sum+3,int64_t(0));
+		std::fill(sumProducts,sumProducts+6,int64_t(0));
+	}
+
+	void setOrigin(int64_t originX_, int64_t originY_, int64_t originZ_)
+	{
+		if(n>0)
+			throw std::runtime_error("GyrationMoments: origin cannot be changed after adding positions");
+		origin[0]=originX_;
+		origin[1]=originY_;
+		origin[2]=originZ_;
+	}
+
+	void add(int64_t x, int64_t y, int64_t z)
+	{
+		x-=origin[0];
+		y-=origin[1];
+		z-=origin[2];
+		n++;
+		sum[0]+=x;
+		sum[1]+=y;
+		sum[2]+=z;
+		sumProducts[0]+=x*x;
+		sumProducts[1]+=y*y;
+		sumProducts[2]+=z*z;
+		sumProducts[3]+=x*y;
+		sumProducts[4]+=x*z;
+		sumProducts[5]+=y*z;
+	}
+
+	//! adds the moments of another part with the same origin
+	void merge(const GyrationMoments& other)
+	{
+		if(other.origin[0]!=origin[0] || other.origin[1]!=origin[1] || other.origin[2]!=origin[2])
+			throw std::runtime_error("GyrationMoments: merged moments need the same origin");
+		n+=other.n;
+		for(int a=0;a<3;a++)
+			sum[a]+=other.sum[a];
+		for(int c=0;c<6;c++)
+			sumProducts[c]+=other.sumProducts[c];
+	}
+
+	int64_t getN() const {return n;}
+
+	//! N^2 times the six tensor components, exact
+	void getN2Tensor(int64_t n2Tensor[6]) const
+	{
+		static const int first[6]={0,1,2,0,0,1};
+		static const int second[6]={0,1,2,1,2,2};
+		for(int c=0;c<6;c++)
+			n2Tensor[c]=n*sumProducts[c]-sum[first[c]]*sum[second[c]];
+	}
+
+private:
+	int64_t origin[3];
+	int64_t n;
+	int64_t sum[3];
+	int64_t sumProducts[6];
+};
+
+/*****************************************************************************/
+/**
+ * @class GyrationTensor
+ * @brief gyration tensor with eigenvalues and shape descriptors
+ * @details The eigenvalues are sorted lambda1 >= lambda2 >= lambda3 and
+ *   Rg2 = lambda1 + lambda2 + lambda3
+ *   asphericity b = lambda1 - (lambda2 + lambda3)/2
+ *   acylindricity c = lambda2 - lambda3
+ *   relative shape anisotropy kappa2 = (b^2 + 3/4 c^2)/Rg2^2
+ * */
+/*****************************************************************************/
+class GyrationTensor
+{
+public:
+	GyrationTensor()
+	{
+		std::fill(components,components+6,0.0);
+		std::fill(eigenvalues,eigenvalues+3,0.0);
+	}
+
+	explicit GyrationTensor(const GyrationMoments& moments)
+	{
+		int64_t n2Tensor[6];
+		moments.getN2Tensor(n2Tensor);
+		const double n2(double(moments.getN())*double(moments.getN()));
+		for(int c=0;c<6;c++)
+			components[c]=(n2>0.0) ? double(n2Tensor[c])/n2 : 0.0;
+		calcEigenvalues();
+	}
+
+	//! components xx, yy, zz, xy, xz, yz
+	double getComponent(int c) const {return components[c];}
+
+	//! eigenvalue i, sorted in descending order
+	double getEigenvalue(int i) const {return eigenvalues[i];}
+
+	double getRg2() const {return components[0]+components[1]+components[2];}
+
+	double getAsphericity() const {return eigenvalues[0]-0.5*(eigenvalues[1]+eigenvalues[2]);}
+
+	double getAcylindricity() const {return eigenvalues[1]-eigenvalues[2];}
+
+	double getRelativeShapeAnisotropy() const
+	{
+		const double rg2(eigenvalues[0]+eigenvalues[1]+eigenvalues[2]);
+		if(rg2<=0.0)
+			return 0.0;
+		const double b(getAsphericity());
+		const double c(getAcylindricity());
+		return (b*b+0.75*c*c)/(rg2*rg2);
+	}
+
+private:
+	double components[6];
+	double eigenvalues[3];
+
+	void calcEigenvalues();
+};
+
+/******************************************************************************/
+/**
+ * @fn void GyrationTensor::calcEigenvalues()
+ * @brief closed form eigenvalues of the symmetric tensor (trigonometric solution of the characteristic polynomial)
+ */
+inline void GyrationTensor::calcEigenvalues()
+{
+	const double xx(components[0]), yy(components[1]), zz(components[2]);
+	const double xy(components[3]), xz(components[4]), yz(components[5]);
+
+	const double offDiagonal(xy*xy+xz*xz+yz*yz);
+	const double mean((xx+yy+zz)/3.0);
+	if(offDiagonal==0.0){
+		eigenvalues[0]=xx;
+		eigenvalues[1]=yy;
+		eigenvalues[2]=zz;
+	}else{
+		// B = (G - mean I)/p has eigenvalues 2 cos(phi + 2 pi k/3) with cos(3 phi) = det(B)/2
+		const double dx(xx-mean), dy(yy-mean), dz(zz-mean);
+		const double p(std::sqrt((dx*dx+dy*dy+dz*dz+2.0*offDiagonal)/6.0));
+		const double det(dx*(dy*dz-yz*yz)-xy*(xy*dz-yz*xz)+xz*(xy*yz-dy*xz));
+		const double r(std::max(-1.0,std::min(1.0,det/(2.0*p*p*p))));
+		const double phi(std::acos(r)/3.0);
+		eigenvalues[0]=mean+2.0*p*std::cos(phi);
+		eigenvalues[2]=mean+2.0*p*std::cos(phi+2.0*M_PI/3.0);
+		eigenvalues[1]=3.0*mean-eigenvalues[0]-eigenvalues[2];
+	}
+	std::sort(eigenvalues,eigenvalues+3);
+	std::swap(eigenvalues[0],eigenvalues[2]);
+}
+
+#endif /* GYRATION_TENSOR_H_ */
@@ -0,0 +1,95 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Histogram of non-negative integer values with one bin per value
+ * @details The bins are allocated once by the constructor or reset(); add()
+ * only increments counters, so it can be called inside the innermost loops.
+ * Values beyond the last bin are counted as overflow. The counts and the sum of
+ * the values are exact integers, so histograms of several threads or frames
+ * can be merged in any order.
+ * */
+/*****************************************************************************/
+
+#ifndef INTEGER_HISTOGRAM_H_
+#define INTEGER_HISTOGRAM_H_
+
+#include <stdexcept>
+#include <vector>
+#include <stdint.h>
+
+/*****************************************************************************/
+/**
+ * @class IntegerHistogram
+ * @brief counts of the values 0..numBins-1 and of larger values
+ * */
+/*****************************************************************************/
+class IntegerHistogram
+{
+public:
+	explicit IntegerHistogram(size_t numBins=0) {reset(numBins);}
+
+	//! allocates numBins empty bins
+	void reset(size_t numBins)
+	{
+		counts.assign(numBins,0);
+		numOverflow=0;
+		numSamples=0;
+		sumValues=0;
+	}
+
+	//! empties the bins without changing their number
+	void clear() {reset(counts.size());}
+
+	void add(uint64_t value)
+	{
+		if(value<counts.size())
+			counts[value]++;
+		else
+			numOverflow++;
+		numSamples++;
+		sumValues+=value;
+	}
+
+	void merge(const IntegerHistogram& other)
+	{
+		if(other.counts.size()!=counts.size())
+			throw std::runtime_error("IntegerHistogram::merge: different number of bins");
+		for(size_t bin=0;bin<counts.size();bin++)
+			counts[bin]+=other.counts[bin];
+		numOverflow+=other.numOverflow;
+		numSamples+=other.numSamples;
+		sumValues+=other.sumValues;
+	}
+
+	size_t getNumBins() const {return counts.size();}
+	uint64_t getCount(size_t bin) const {return counts[bin];}
+	uint64_t getNumOverflow() const {return numOverflow;}
+	uint64_t getNumSamples() const {return numSamples;}
+
+	//! mean of all values, including the overflow
+	double getMean() const {return numSamples>0 ? double(sumValues)/double(numSamples) : 0.0;}
+
+	//! columns value, count and fraction of all samples, up to the last non-empty bin
+	std::vector< std::vector<double> > getColumns() const
+	{
+		size_t numRows(counts.size());
+		while(numRows>0 && counts[numRows-1]==0)
+			numRows--;
+
+		std::vector< std::vector<double> > columns(3,std::vector<double>(numRows));
+		for(size_t bin=0;bin<numRows;bin++){
+			columns[0][bin]=double(bin);
+			columns[1][bin]=double(counts[bin]);
+			columns[2][bin]=numSamples>0 ? double(counts[bin])/double(numSamples) : 0.0;
+		}
+		return columns;
+	}
+
+private:
+	std::vector<uint64_t> counts;
+	uint64_t numOverflow;
+	uint64_t numSamples;
+	uint64_t sumValues;
+};
+
+#endif /* INTEGER_HISTOGRAM_H_ */
@@ -0,0 +1,87 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Sums of squared distances between monomers of a chain at fixed contour separation
+ * @details The chain is given by contiguous coordinate arrays x, y, z in
+ * contour order. For a separation n the kernel sums |r_(i+n) - r_i|^2 over all
+ * i, which reads two sequential streams of the same block and vectorizes
+ * (AVX2, eight monomers per step, products summed in 64 bit lanes). All sums
+ * are exact integers, so partial sums of different chains or threads can be
+ * added in any order.
+ * */
+/*****************************************************************************/
+
+#ifndef INTERNAL_DISTANCES_H_
+#define INTERNAL_DISTANCES_H_
+
+#include <cstddef>
+#include <stdint.h>
+
+#include "CpuFeatures.h"
+
+namespace InternalDistances
+{
+	//! reference implementation, also used for the remainder of the AVX2 loop
+	inline int64_t sumSquaredSeparationsScalar(const int32_t* x, const int32_t* y, const int32_t* z, size_t length, size_t separation)
+	{
+		int64_t sum(0);
+		for(size_t i=0;i+separation<length;i++){
+			const int64_t dx(x[i+separation]-x[i]);
+			const int64_t dy(y[i+separation]-y[i]);
+			const int64_t dz(z[i+separation]-z[i]);
+			sum+=dx*dx+dy*dy+dz*dz;
+		}
+		return sum;
+	}
+
+#ifdef CPU_FEATURES_X86
+	//! squares of the even and the odd 32 bit lanes of d added to the four 64 bit lanes of sum
+	__attribute__((target("avx2")))
+	inline __m256i addSquaresAVX2(__m256i sum, __m256i d)
+	{
+		sum=_mm256_add_epi64(sum,_mm256_mul_epi32(d,d));
+		const __m256i odd=_mm256_srli_epi64(d,32);
+		return _mm256_add_epi64(sum,_mm256_mul_epi32(odd,odd));
+	}
+
+	__attribute__((target("avx2")))
+	inline int64_t sumSquaredSeparationsAVX2(const int32_t* x, const int32_t* y, const int32_t* z, size_t length, size_t separation)
+	{
+		if(separation>=length)
+			return 0;
+		const size_t numPairs(length-separation);
+		__m256i sum=_mm256_setzero_si256();
+		size_t i(0);
+		for(;i+8<=numPairs;i+=8){
+			const __m256i dx=_mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x+i+separation)),_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x+i)));
+			const __m256i dy=_mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y+i+separation)),_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y+i)));
+			const __m256i dz=_mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(z+i+separation)),_mm256_loadu_si256(reinterpret_cast<const __m256i*>(z+i)));
+			sum=addSquaresAVX2(sum,dx);
+			sum=addSquaresAVX2(sum,dy);
+			sum=addSquaresAVX2(sum,dz);
+		}
+		int64_t lanes[4];
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes),sum);
+		return lanes[0]+lanes[1]+lanes[2]+lanes[3]+sumSquaredSeparationsScalar(x+i,y+i,z+i,length-i,separation);
+	}
+#endif /* CPU_FEATURES_X86 */
+
+	//! SUM_i |r_(i+separation) - r_i|^2 of a chain of length monomers
+	inline int64_t sumSquaredSeparations(const int32_t* x, const int32_t* y, const int32_t* z, size_t length, size_t separation)
+	{
+#ifdef CPU_FEATURES_X86
+		if(CpuFeatures::getInstructionSet()==CpuFeatures::AVX2)
+			return sumSquaredSeparationsAVX2(x,y,z,length,separation);
+#endif
+		return sumSquaredSeparationsScalar(x,y,z,length,separation);
+	}
+
+	//! adds the sums of all separations 1 <= n < length of one chain to sums[n]
+	inline void addAllSeparations(const int32_t* x, const int32_t* y, const int32_t* z, size_t length, int64_t* sums)
+	{
+		for(size_t n=1;n<length;n++)
+			sums[n]+=sumSquaredSeparations(x,y,z,length,n);
+	}
+}
+
+#endif /* INTERNAL_DISTANCES_H_ */
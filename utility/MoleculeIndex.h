@@ -0,0 +1,138 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Molecules as connected components of the bond graph
+ * @details The components are found once by a breadth first search over the
+ * bonds of the molecules container. The monomer indices of every molecule are
+ * stored contiguously (compressed row storage), in breadth first order, so a
+ * chain can be unwrapped into a contiguous coordinate block by following the
+ * bond to its parent with minimum image vectors.
+ * */
+/*****************************************************************************/
+
+#ifndef MOLECULE_INDEX_H_
+#define MOLECULE_INDEX_H_
+
+#include <vector>
+#include <stdexcept>
+#include <stdint.h>
+
+#include <LeMonADE/utility/Vector3D.h>
+#include <LeMonADE/utility/DistanceCalculation.h>
+
+/*****************************************************************************/
+/**
+ * @class MoleculeIndex
+ * @brief monomer indices of all molecules, grouped by bond connectivity
+ * @details Molecules are numbered in the order of their lowest monomer index.
+ * The first monomer of every molecule is its lowest index and the root of the
+ * breadth first search. Changes of the bonds require a new call of build().
+ * */
+/*****************************************************************************/
+class MoleculeIndex
+{
+public:
+	MoleculeIndex(){}
+
+	//! finds the connected components of the bond graph of molecules
+	template<class MoleculesType>
+	void build(const MoleculesType& molecules);
+
+	size_t getNumMolecules() const {return moleculeOffsets.empty() ? 0 : moleculeOffsets.size()-1;}
+
+	//! number of monomers in molecule m
+	size_t getMoleculeSize(size_t m) const {return moleculeOffsets[m+1]-moleculeOffsets[m];}
+
+	//! monomer indices of molecule m in breadth first order
+	const uint32_t* getMonomers(size_t m) const {return &monomers[moleculeOffsets[m]];}
+
+	//! position of the bonded predecessor of the k-th monomer of molecule m in getMonomers(m), -1 for the root
+	int32_t getParent(size_t m, size_t k) const {return parents[moleculeOffsets[m]+k];}
+
+	//! molecule containing the monomer with index monomer
+	uint32_t getMoleculeOfMonomer(uint32_t monomer) const {return moleculeOfMonomer[monomer];}
+
+	/**
+	 * @brief unwrapped positions of the monomers of molecule m in the order of getMonomers(m)
+	 * @details The root keeps its position, every other monomer is placed at its
+	 * parent plus the minimum image bond vector. x, y, z need getMoleculeSize(m) entries.
+	 */
+	template<class IngredientsType>
+	void unwrap(const IngredientsType& ingredients, size_t m, int32_t* x, int32_t* y, int32_t* z) const;
+
+private:
+	//! molecule m consists of monomers[moleculeOffsets[m]..moleculeOffsets[m+1]-1]
+	std::vector<size_t> moleculeOffsets;
+	std::vector<uint32_t> monomers;
+	std::vector<int32_t> parents;
+	std::vector<uint32_t> moleculeOfMonomer;
+};
+
+/******************************************************************************/
+/**
+ * @fn void MoleculeIndex::build(const MoleculesType& molecules)
+ * @brief breadth first search from every monomer that is not yet assigned to a molecule
+ */
+template<class MoleculesType>
+void MoleculeIndex::build(const MoleculesType& molecules)
+{
+	const uint32_t numMonomers(molecules.size());
+	const uint32_t unassigned(uint32_t(-1));
+
+	moleculeOffsets.assign(1,0);
+	monomers.clear();
+	monomers.reserve(numMonomers);
+	parents.clear();
+	parents.reserve(numMonomers);
+	moleculeOfMonomer.assign(numMonomers,unassigned);
+
+	for(uint32_t root=0;root<numMonomers;root++){
+		if(moleculeOfMonomer[root]!=unassigned)
+			continue;
+
+		const uint32_t molecule(moleculeOffsets.size()-1);
+		const size_t first(monomers.size());
+		moleculeOfMonomer[root]=molecule;
+		monomers.push_back(root);
+		parents.push_back(-1);
+
+		// the part of monomers behind first is the queue of the search
+		for(size_t k=first;k<monomers.size();k++){
+			const uint32_t current(monomers[k]);
+			for(uint32_t l=0;l<molecules.getNumLinks(current);l++){
+				const uint32_t neighbor(molecules.getNeighborIdx(current,l));
+				if(neighbor>=numMonomers)
+					throw std::runtime_error("MoleculeIndex: bond to a monomer index out of range");
+				if(moleculeOfMonomer[neighbor]!=unassigned)
+					continue;
+				moleculeOfMonomer[neighbor]=molecule;
+				monomers.push_back(neighbor);
+				parents.push_back(int32_t(k-first));
+			}
+		}
+		moleculeOffsets.push_back(monomers.size());
+	}
+}
+
+template<class IngredientsType>
+void MoleculeIndex::unwrap(const IngredientsType& ingredients, size_t m, int32_t* x, int32_t* y, int32_t* z) const
+{
+	const uint32_t* block(getMonomers(m));
+	const int32_t* blockParents(&parents[moleculeOffsets[m]]);
+	const size_t size(getMoleculeSize(m));
+
+	const VectorInt3& root(ingredients.getMolecules()[block[0]]);
+	x[0]=root.getX();
+	y[0]=root.getY();
+	z[0]=root.getZ();
+	for(size_t k=1;k<size;k++){
+		const int32_t p(blockParents[k]);
+		VectorInt3 bond(LemonadeDistCalcs::MinImageVector(VectorInt3(ingredients.getMolecules()[block[p]]),
+		                                                  VectorInt3(ingredients.getMolecules()[block[k]]),ingredients));
+		x[k]=x[p]+bond.getX();
+		y[k]=y[p]+bond.getY();
+		z[k]=z[p]+bond.getZ();
+	}
+}
+
+#endif /* MOLECULE_INDEX_H_ */
@@ -0,0 +1,198 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Lattice of monomer indices for neighbour lookups in the NN-shell
+ * @details The typed lattice of the features only knows the attribute at a
+ * site, not which monomer sits there. This lattice stores the index of every
+ * monomer of one attribute tag at its (folded) position and is refreshed every
+ * frame by clearing the sites of the previous frame, so the costs are O(N) per
+ * frame and not O(box). A shell query visits the fixed offsets d around a
+ * position with the minimum image of d satisfying d*d <= 6, which finds exactly
+ * the monomers m with MinImageVector(m, pos)^2 <= 6. For periodic boxes smaller
+ * than 5 the offsets that fold onto the same site are visited only once.
+ * */
+/*****************************************************************************/
+
+#ifndef MONOMER_INDEX_LATTICE_H_
+#define MONOMER_INDEX_LATTICE_H_
+
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <stdint.h>
+
+#include <LeMonADE/utility/Vector3D.h>
+
+/*****************************************************************************/
+/**
+ * @class MonomerIndexLattice
+ * @brief index of the monomer at every lattice site (-1 if empty) for one attribute tag
+ * */
+/*****************************************************************************/
+class MonomerIndexLattice
+{
+public:
+	//! largest squared distance of a site in the NN-shell and the number of sites of the shell
+	enum {MAX_SQUARED_DISTANCE=6, MAX_SHELL_SITES=81};
+
+	MonomerIndexLattice():numSites(0){}
+
+	//! allocates the lattice for the box of ing and prepares the shell offsets
+	template<class IngredientsType>
+	void setup(const IngredientsType& ing);
+
+	//! replaces the monomers of the last call by all monomers with attribute tag
+	template<class IngredientsType>
+	void update(const IngredientsType& ing, int32_t tag);
+
+	//! number of monomers in the NN-shell of pos (pos itself included)
+	size_t countShell(const VectorInt3& pos) const;
+
+	//! appends the indices of the monomers in the NN-shell of pos to indices
+	void collectShell(const VectorInt3& pos, std::vector<uint32_t>& indices) const;
+
+	//! writes the indices of the monomers in the NN-shell of pos to indices[0..MAX_SHELL_SITES-1], returns their number
+	size_t collectShell(const VectorInt3& pos, uint32_t* indices) const;
+
+	//! number of monomers on the lattice
+	size_t getNumMonomers() const {return occupied.size();}
+
+private:
+	int32_t box[3];
+	bool periodic[3];
+	size_t numSites;
+
+	std::vector<int32_t> sites;
+
+	//! sites filled by the last update()
+	std::vector<size_t> occupied;
+
+	//! shell offsets, the components are minimal images (|d| <= 2)
+	std::vector<int32_t> offsetX;
+	std::vector<int32_t> offsetY;
+	std::vector<int32_t> offsetZ;
+
+	//! coordinate folded into [0,box) along axis a
+	int32_t fold(int32_t c, int a) const {c%=box[a]; return c<0 ? c+box[a] : c;}
+
+	//! index of the site at the folded position p plus offset d along axis a, -1 outside a non-periodic box
+	int32_t shift(int32_t p, int32_t d, int a) const
+	{
+		p+=d;
+		if(p<0)
+			return periodic[a] ? p+box[a] : -1;
+		if(p>=box[a])
+			return periodic[a] ? p-box[a] : -1;
+		return p;
+	}
+
+	template<class Function>
+	void visitShell(const VectorInt3& pos, Function f) const;
+};
+
+template<class IngredientsType>
+void MonomerIndexLattice::setup(const IngredientsType& ing)
+{
+	box[0]=int32_t(ing.getBoxX());
+	box[1]=int32_t(ing.getBoxY());
+	box[2]=int32_t(ing.getBoxZ());
+	periodic[0]=ing.isPeriodicX();
+	periodic[1]=ing.isPeriodicY();
+	periodic[2]=ing.isPeriodicZ();
+
+	if(box[0]<=0 || box[1]<=0 || box[2]<=0)
+		throw std::runtime_error("MonomerIndexLattice::setup: box is not set");
+
+	numSites=size_t(box[0])*size_t(box[1])*size_t(box[2]);
+	sites.assign(numSites,-1);
+	occupied.clear();
+
+	// per axis the offsets -2..2 that lead to different sites, with their minimal image
+	std::vector<int32_t> axisOffsets[3];
+	for(int a=0;a<3;a++){
+		const int32_t candidates[5]={0,-1,1,-2,2};
+		std::vector<int32_t> residues;
+		for(int c=0;c<5;c++){
+			const int32_t residue(periodic[a] ? fold(candidates[c],a) : candidates[c]);
+			bool known(false);
+			for(size_t r=0;r<residues.size();r++)
+				known=known || residues[r]==residue;
+			if(!known){
+				residues.push_back(residue);
+				axisOffsets[a].push_back(candidates[c]);
+			}
+		}
+	}
+
+	offsetX.clear();
+	offsetY.clear();
+	offsetZ.clear();
+	for(size_t i=0;i<axisOffsets[0].size();i++)
+		for(size_t j=0;j<axisOffsets[1].size();j++)
+			for(size_t k=0;k<axisOffsets[2].size();k++){
+				const int32_t dx(axisOffsets[0][i]), dy(axisOffsets[1][j]), dz(axisOffsets[2][k]);
+				if(dx*dx+dy*dy+dz*dz<=MAX_SQUARED_DISTANCE){
+					offsetX.push_back(dx);
+					offsetY.push_back(dy);
+					offsetZ.push_back(dz);
+				}
+			}
+}
+
+template<class IngredientsType>
+void MonomerIndexLattice::update(const IngredientsType& ing, int32_t tag)
+{
+	for(size_t i=0;i<occupied.size();i++)
+		sites[occupied[i]]=-1;
+	occupied.clear();
+
+	for(size_t n=0;n<ing.getMolecules().size();n++){
+		if(ing.getMolecules()[n].getAttributeTag()!=tag)
+			continue;
+		const VectorInt3& pos(ing.getMolecules()[n]);
+		const int32_t x(fold(pos.getX(),0)), y(fold(pos.getY(),1)), z(fold(pos.getZ(),2));
+		const size_t site((size_t(z)*size_t(box[1])+size_t(y))*size_t(box[0])+size_t(x));
+		if(sites[site]>=0){
+			std::stringstream error;
+			error<<"MonomerIndexLattice::update: monomers "<<sites[site]<<" and "<<n<<" on the same lattice site";
+			throw std::runtime_error(error.str());
+		}
+		sites[site]=int32_t(n);
+		occupied.push_back(site);
+	}
+}
+
+template<class Function>
+void MonomerIndexLattice::visitShell(const VectorInt3& pos, Function f) const
+{
+	const int32_t x(fold(pos.getX(),0)), y(fold(pos.getY(),1)), z(fold(pos.getZ(),2));
+	for(size_t o=0;o<offsetX.size();o++){
+		const int32_t sx(shift(x,offsetX[o],0)), sy(shift(y,offsetY[o],1)), sz(shift(z,offsetZ[o],2));
+		if(sx<0 || sy<0 || sz<0)
+			continue;
+		const int32_t index(sites[(size_t(sz)*size_t(box[1])+size_t(sy))*size_t(box[0])+size_t(sx)]);
+		if(index>=0)
+			f(uint32_t(index));
+	}
+}
+
+inline size_t MonomerIndexLattice::countShell(const VectorInt3& pos) const
+{
+	size_t count(0);
+	visitShell(pos,[&count](uint32_t){count++;});
+	return count;
+}
+
+inline void MonomerIndexLattice::collectShell(const VectorInt3& pos, std::vector<uint32_t>& indices) const
+{
+	visitShell(pos,[&indices](uint32_t index){indices.push_back(index);});
+}
+
+inline size_t MonomerIndexLattice::collectShell(const VectorInt3& pos, uint32_t* indices) const
+{
+	size_t count(0);
+	visitShell(pos,[&count,indices](uint32_t index){indices[count++]=index;});
+	return count;
+}
+
+#endif /* MONOMER_INDEX_LATTICE_H_ */
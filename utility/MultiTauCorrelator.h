@@ -0,0 +1,172 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Multiple-tau correlator for the autocorrelation of many channels with bounded memory
+ * @details The time series of every channel is correlated on a hierarchy of
+ * levels (Ramirez et al., J. Chem. Phys. 133, 154103 (2010)). Level 0 keeps the
+ * last pointsPerLevel values and correlates lags 0..pointsPerLevel-1, every
+ * further level is fed with averages of averaging values of the level below
+ * and covers the lags pointsPerLevel/averaging..pointsPerLevel-1 in units of
+ * averaging^level frames. The memory is numLevels*pointsPerLevel values per
+ * channel, independent of the length of the trajectory, while the lags grow
+ * up to pointsPerLevel*averaging^(numLevels-1) frames. The products of all
+ * channels are summed, so getCorrelation() is the average over channels and
+ * time origins.
+ * */
+/*****************************************************************************/
+
+#ifndef MULTI_TAU_CORRELATOR_H_
+#define MULTI_TAU_CORRELATOR_H_
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <stdint.h>
+
+/*****************************************************************************/
+/**
+ * @class MultiTauCorrelator
+ * @brief <x(t) x(t+lag)> averaged over the channels, on a logarithmic grid of lags
+ * */
+/*****************************************************************************/
+class MultiTauCorrelator
+{
+public:
+	MultiTauCorrelator(size_t numChannels_=0, size_t numLevels_=16, size_t pointsPerLevel_=16, size_t averaging_=2);
+
+	//! adds the values of all channels at the next frame
+	void add(const double* values);
+
+	//! number of lags with at least one sample
+	size_t getNumLags() const;
+
+	//! lag i in frames
+	uint64_t getLag(size_t i) const {return lagOf(i);}
+
+	//! average of x(t) x(t+getLag(i)) over channels and time origins
+	double getCorrelation(size_t i) const;
+
+	//! number of time origins of lag i
+	uint64_t getNumSamples(size_t i) const {return level(i).counts[point(i)];}
+
+	size_t getNumChannels() const {return numChannels;}
+
+private:
+	struct Level {
+		//! pointsPerLevel values of every channel, the newest at head
+		std::vector<double> buffer;
+		size_t head;
+		size_t filled;
+
+		//! sum of the values not yet passed to the next level
+		std::vector<double> accumulator;
+		size_t numAccumulated;
+
+		std::vector<double> correlation;
+		std::vector<uint64_t> counts;
+	};
+
+	size_t numChannels;
+	size_t pointsPerLevel;
+	size_t averaging;
+
+	std::vector<Level> levels;
+
+	void addToLevel(size_t k, const double* values);
+
+	//! first point of level k that is not covered by the level below
+	size_t firstPoint(size_t k) const {return k==0 ? 0 : pointsPerLevel/averaging;}
+
+	//! level and point of lag i in the order of increasing lags
+	size_t levelIndex(size_t i) const {return i<pointsPerLevel ? 0 : 1+(i-pointsPerLevel)/(pointsPerLevel-pointsPerLevel/averaging);}
+	size_t point(size_t i) const {return i<pointsPerLevel ? i : pointsPerLevel/averaging+(i-pointsPerLevel)%(pointsPerLevel-pointsPerLevel/averaging);}
+	const Level& level(size_t i) const {return levels[levelIndex(i)];}
+
+	uint64_t lagOf(size_t i) const
+	{
+		uint64_t lag(point(i));
+		for(size_t k=0;k<levelIndex(i);k++)
+			lag*=averaging;
+		return lag;
+	}
+};
+
+inline MultiTauCorrelator::MultiTauCorrelator(size_t numChannels_, size_t numLevels_, size_t pointsPerLevel_, size_t averaging_):
+	numChannels(numChannels_),
+	pointsPerLevel(pointsPerLevel_),
+	averaging(averaging_)
+{
+	if(numLevels_==0 || averaging<2 || pointsPerLevel<averaging || pointsPerLevel%averaging!=0)
+		throw std::runtime_error("MultiTauCorrelator: pointsPerLevel must be a multiple of averaging >= 2 and at least one level is needed");
+
+	levels.resize(numLevels_);
+	for(size_t k=0;k<levels.size();k++){
+		levels[k].buffer.assign(pointsPerLevel*numChannels,0.0);
+		levels[k].head=0;
+		levels[k].filled=0;
+		levels[k].accumulator.assign(numChannels,0.0);
+		levels[k].numAccumulated=0;
+		levels[k].correlation.assign(pointsPerLevel,0.0);
+		levels[k].counts.assign(pointsPerLevel,0);
+	}
+}
+
+inline void MultiTauCorrelator::add(const double* values)
+{
+	addToLevel(0,values);
+}
+
+/******************************************************************************/
+/**
+ * @fn void MultiTauCorrelator::addToLevel()
+ * @brief stores the values as newest entry of level k, correlates them with the stored ones and passes averages up
+ */
+inline void MultiTauCorrelator::addToLevel(size_t k, const double* values)
+{
+	Level& current(levels[k]);
+
+	current.head=(current.head+pointsPerLevel-1)%pointsPerLevel;
+	std::copy(values,values+numChannels,current.buffer.begin()+current.head*numChannels);
+	current.filled=std::min(current.filled+1,pointsPerLevel);
+
+	for(size_t j=firstPoint(k);j<current.filled;j++){
+		const double* older(&current.buffer[((current.head+j)%pointsPerLevel)*numChannels]);
+		double sum(0.0);
+		for(size_t c=0;c<numChannels;c++)
+			sum+=values[c]*older[c];
+		current.correlation[j]+=sum;
+		current.counts[j]++;
+	}
+
+	if(k+1>=levels.size())
+		return;
+
+	for(size_t c=0;c<numChannels;c++)
+		current.accumulator[c]+=values[c];
+	if(++current.numAccumulated==averaging){
+		for(size_t c=0;c<numChannels;c++)
+			current.accumulator[c]/=double(averaging);
+		addToLevel(k+1,current.accumulator.data());
+		std::fill(current.accumulator.begin(),current.accumulator.end(),0.0);
+		current.numAccumulated=0;
+	}
+}
+
+inline size_t MultiTauCorrelator::getNumLags() const
+{
+	size_t numLags(0);
+	const size_t total(pointsPerLevel+(levels.size()-1)*(pointsPerLevel-pointsPerLevel/averaging));
+	while(numLags<total && getNumSamples(numLags)>0)
+		numLags++;
+	return numLags;
+}
+
+inline double MultiTauCorrelator::getCorrelation(size_t i) const
+{
+	const uint64_t samples(getNumSamples(i));
+	if(samples==0 || numChannels==0)
+		return 0.0;
+	return level(i).correlation[point(i)]/(double(samples)*double(numChannels));
+}
+
+#endif /* MULTI_TAU_CORRELATOR_H_ */
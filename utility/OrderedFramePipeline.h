@@ -0,0 +1,204 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Evaluates frames on worker threads and merges the results in frame order
+ * @details The pipeline owns a ring of capacity slots, each with a frame and a
+ * result. The reading thread fills the frame of the next free slot and submits
+ * it; a worker evaluates it into the result of the same slot. Finished results
+ * are merged on the reading thread strictly in the order of submission, so
+ * every accumulation in merge sees the same sequence as a serial run and the
+ * output does not depend on the number of threads. At most capacity frames
+ * are in flight, so the memory is bounded and the slots are reused without
+ * allocations once their vectors have grown.
+ * */
+/*****************************************************************************/
+
+#ifndef ORDERED_FRAME_PIPELINE_H_
+#define ORDERED_FRAME_PIPELINE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+/*****************************************************************************/
+/**
+ * @class OrderedFramePipeline
+ * @brief bounded queue of frames for worker threads with an in-order merge
+ * @details nextFrame(), submit() and finish() must be called from one thread,
+ * which is also the thread that calls merge. An exception thrown by evaluate
+ * is rethrown by the next call of nextFrame() or finish().
+ * */
+/*****************************************************************************/
+template<class FrameType, class ResultType>
+class OrderedFramePipeline
+{
+public:
+	typedef std::function<void(const FrameType&, ResultType&)> EvaluateFunction;
+	typedef std::function<void(const ResultType&)> MergeFunction;
+
+	//! capacity is the number of frames in flight, at least one per thread is recommended
+	OrderedFramePipeline(uint32_t numThreads, size_t capacity, EvaluateFunction evaluate_, MergeFunction merge_);
+
+	//! stops the workers, results that are not merged yet are discarded
+	~OrderedFramePipeline();
+
+	//! frame of the next free slot, merges finished results and waits if all slots are in flight
+	FrameType& nextFrame();
+
+	//! hands the frame returned by nextFrame() to the workers
+	void submit();
+
+	//! waits for all submitted frames and merges their results
+	void finish();
+
+private:
+	struct Slot {
+		FrameType frame;
+		ResultType result;
+		bool done;
+	};
+
+	EvaluateFunction evaluate;
+	MergeFunction merge;
+
+	std::vector<Slot> slots;
+	uint64_t numSubmitted;
+	uint64_t numMerged;
+
+	//! slots waiting for a worker
+	std::deque<size_t> pending;
+
+	std::mutex mutex;
+	std::condition_variable workCondition;
+	std::condition_variable doneCondition;
+	bool closing;
+	std::exception_ptr error;
+	std::vector<std::thread> workers;
+
+	void run();
+	void mergeFinished(std::unique_lock<std::mutex>& lock, bool all);
+	void stop();
+};
+
+template<class FrameType, class ResultType>
+OrderedFramePipeline<FrameType,ResultType>::OrderedFramePipeline(uint32_t numThreads, size_t capacity, EvaluateFunction evaluate_, MergeFunction merge_):
+	evaluate(evaluate_),
+	merge(merge_),
+	slots(capacity > 0 ? capacity : 1),
+	numSubmitted(0),
+	numMerged(0),
+	closing(false)
+{
+	for(size_t s=0;s<slots.size();s++)
+		slots[s].done=false;
+	for(uint32_t t=0;t<(numThreads > 0 ? numThreads : 1);t++)
+		workers.push_back(std::thread(&OrderedFramePipeline::run,this));
+}
+
+template<class FrameType, class ResultType>
+OrderedFramePipeline<FrameType,ResultType>::~OrderedFramePipeline()
+{
+	stop();
+}
+
+template<class FrameType, class ResultType>
+FrameType& OrderedFramePipeline<FrameType,ResultType>::nextFrame()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	mergeFinished(lock,false);
+	return slots[numSubmitted%slots.size()].frame;
+}
+
+template<class FrameType, class ResultType>
+void OrderedFramePipeline<FrameType,ResultType>::submit()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending.push_back(numSubmitted%slots.size());
+		numSubmitted++;
+	}
+	workCondition.notify_one();
+}
+
+template<class FrameType, class ResultType>
+void OrderedFramePipeline<FrameType,ResultType>::finish()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	mergeFinished(lock,true);
+}
+
+/******************************************************************************/
+/**
+ * @fn void OrderedFramePipeline::mergeFinished()
+ * @brief merges finished results in order until a slot is free (or all are merged if all is set)
+ */
+template<class FrameType, class ResultType>
+void OrderedFramePipeline<FrameType,ResultType>::mergeFinished(std::unique_lock<std::mutex>& lock, bool all)
+{
+	while(true){
+		if(error)
+			std::rethrow_exception(error);
+		while(numMerged<numSubmitted && slots[numMerged%slots.size()].done){
+			Slot& slot(slots[numMerged%slots.size()]);
+			// the slot is not touched by the workers until it is submitted again
+			lock.unlock();
+			merge(slot.result);
+			lock.lock();
+			slot.done=false;
+			numMerged++;
+		}
+		if(all ? numMerged==numSubmitted : numSubmitted-numMerged<slots.size())
+			return;
+		doneCondition.wait(lock);
+	}
+}
+
+/******************************************************************************/
+/**
+ * @fn void OrderedFramePipeline::run()
+ * @brief loop of a worker thread: evaluates pending slots until the pipeline is stopped
+ */
+template<class FrameType, class ResultType>
+void OrderedFramePipeline<FrameType,ResultType>::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true){
+		workCondition.wait(lock,[this](){return closing || !pending.empty();});
+		if(pending.empty())
+			break;
+		Slot& slot(slots[pending.front()]);
+		pending.pop_front();
+
+		lock.unlock();
+		std::exception_ptr slotError;
+		try{ evaluate(slot.frame,slot.result); }
+		catch(...){ slotError=std::current_exception(); }
+		lock.lock();
+
+		if(slotError && !error)
+			error=slotError;
+		slot.done=true;
+		doneCondition.notify_all();
+	}
+}
+
+template<class FrameType, class ResultType>
+void OrderedFramePipeline<FrameType,ResultType>::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closing=true;
+		pending.clear();
+	}
+	workCondition.notify_all();
+	for(size_t t=0;t<workers.size();t++)
+		if(workers[t].joinable())
+			workers[t].join();
+}
+
+#endif /* ORDERED_FRAME_PIPELINE_H_ */
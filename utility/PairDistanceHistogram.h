@@ -0,0 +1,185 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Histogram of squared integer pair distances with memory linear in the extent
+ * @details Squared distances below exactLimit (r < 1024) are counted exactly,
+ * one bin per integer r^2. Larger distances are counted in bins of width
+ * farBinWidth in r, which also sum the integer offsets of r^2 from the lower
+ * edge of the bin, so every bin enters the Debye sum at the root mean square
+ * distance of its pairs. A dense histogram over r^2 would grow with the
+ * square of the extent of the coordinates, these far bins grow linearly.
+ * All sums are integers, so merging the histograms of several threads gives
+ * the same result for any distribution of the pairs onto the threads.
+ * More than maxFarBins far bins (distances beyond about 2.6e5 lattice units)
+ * are refused with an exception.
+ * */
+/*****************************************************************************/
+
+#ifndef PAIR_DISTANCE_HISTOGRAM_H_
+#define PAIR_DISTANCE_HISTOGRAM_H_
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <stdint.h>
+
+/*****************************************************************************/
+/**
+ * @class PairDistanceHistogram
+ * @brief exact counts of small squared distances and linear bins of large distances
+ * */
+/*****************************************************************************/
+class PairDistanceHistogram
+{
+public:
+	//! squared distances below are counted exactly
+	static const uint64_t exactLimit=uint64_t(1)<<20;
+
+	//! upper limit of the number of bins of large distances
+	static const size_t maxFarBins=size_t(1)<<24;
+
+	//! width in r of the bins of large distances
+	static double farBinWidth() {return 1.0/64.0;}
+
+	//! makes room for all squared distances up to maxR2, the counts are kept
+	void reserve(uint64_t maxR2);
+
+	//! sets all counts to zero and keeps the memory
+	void clear();
+
+	//! adds the counts of other
+	void merge(const PairDistanceHistogram& other);
+
+	//! counts one pair at squared distance r2, reserve() has to cover r2
+	void add(uint64_t r2)
+	{
+		if(r2<exactLimit)
+			exact[r2]++;
+		else
+			addFar(r2);
+	}
+
+	//! pairs at the same position
+	uint64_t getSamePosition() const {return exact.empty() ? 0 : exact[0];}
+
+	/**
+	 * @brief occupied distances r>0 of the weighted sum of several histograms
+	 * @details Appends the distance and SUM_p weights[p]*count_p of every
+	 * occupied bin to distance and weight, in ascending order. A far bin is
+	 * placed at the root of the weighted mean r^2 of its pairs.
+	 * @return weighted number of pairs at the same position
+	 */
+	static double collect(const std::vector<const PairDistanceHistogram*>& parts, const std::vector<double>& weights,
+	                      std::vector<double>& distance, std::vector<double>& weight);
+
+private:
+	std::vector<uint64_t> exact;
+	std::vector<uint64_t> farCounts;
+	std::vector<int64_t> farSumOffsets;
+
+	static double exactLimitR() {return 1024.0;}
+
+	//! lower edge of far bin in r^2, rounded down
+	static uint64_t farBinStart(size_t bin)
+	{
+		const double r(exactLimitR()+double(bin)*farBinWidth());
+		return uint64_t(r*r);
+	}
+
+	void addFar(uint64_t r2)
+	{
+		const double r(std::sqrt(double(r2)));
+		const size_t bin(size_t((r-exactLimitR())/farBinWidth()));
+		farCounts[bin]++;
+		farSumOffsets[bin]+=int64_t(r2)-int64_t(farBinStart(bin));
+	}
+};
+
+inline void PairDistanceHistogram::reserve(uint64_t maxR2)
+{
+	const size_t numExact(size_t(std::min(maxR2+1,uint64_t(exactLimit))));
+	if(exact.size()<numExact)
+		exact.resize(numExact,0);
+	if(maxR2<exactLimit)
+		return;
+
+	const double maxR(std::sqrt(double(maxR2)));
+	const double numFar(std::floor((maxR-exactLimitR())/farBinWidth())+1.0);
+	if(numFar>double(maxFarBins)){
+		std::stringstream message;
+		message << "PairDistanceHistogram: pair distances up to " << maxR << " lattice units need more than "
+		        << maxFarBins << " bins, the coordinates extend too far";
+		throw std::runtime_error(message.str());
+	}
+	if(farCounts.size()<size_t(numFar)){
+		farCounts.resize(size_t(numFar),0);
+		farSumOffsets.resize(size_t(numFar),0);
+	}
+}
+
+inline void PairDistanceHistogram::clear()
+{
+	std::fill(exact.begin(),exact.end(),0);
+	std::fill(farCounts.begin(),farCounts.end(),0);
+	std::fill(farSumOffsets.begin(),farSumOffsets.end(),0);
+}
+
+inline void PairDistanceHistogram::merge(const PairDistanceHistogram& other)
+{
+	if(exact.size()<other.exact.size())
+		exact.resize(other.exact.size(),0);
+	if(farCounts.size()<other.farCounts.size()){
+		farCounts.resize(other.farCounts.size(),0);
+		farSumOffsets.resize(other.farCounts.size(),0);
+	}
+	for(size_t r2=0;r2<other.exact.size();r2++)
+		exact[r2]+=other.exact[r2];
+	for(size_t bin=0;bin<other.farCounts.size();bin++){
+		farCounts[bin]+=other.farCounts[bin];
+		farSumOffsets[bin]+=other.farSumOffsets[bin];
+	}
+}
+
+inline double PairDistanceHistogram::collect(const std::vector<const PairDistanceHistogram*>& parts, const std::vector<double>& weights,
+                                             std::vector<double>& distance, std::vector<double>& weight)
+{
+	size_t numExact(0), numFar(0);
+	for(size_t p=0;p<parts.size();p++){
+		numExact=std::max(numExact,parts[p]->exact.size());
+		numFar=std::max(numFar,parts[p]->farCounts.size());
+	}
+
+	double samePosition(0.0);
+	for(size_t r2=0;r2<numExact;r2++){
+		double w(0.0);
+		for(size_t p=0;p<parts.size();p++)
+			if(r2<parts[p]->exact.size())
+				w+=weights[p]*double(parts[p]->exact[r2]);
+		if(w==0.0)
+			continue;
+		if(r2==0){
+			samePosition=w;
+		}else{
+			distance.push_back(std::sqrt(double(r2)));
+			weight.push_back(w);
+		}
+	}
+	for(size_t bin=0;bin<numFar;bin++){
+		double w(0.0), sumOffsets(0.0);
+		for(size_t p=0;p<parts.size();p++){
+			if(bin<parts[p]->farCounts.size()){
+				w+=weights[p]*double(parts[p]->farCounts[bin]);
+				sumOffsets+=weights[p]*double(parts[p]->farSumOffsets[bin]);
+			}
+		}
+		if(w==0.0)
+			continue;
+		distance.push_back(std::sqrt(double(farBinStart(bin))+sumOffsets/w));
+		weight.push_back(w);
+	}
+	return samePosition;
+}
+
+#endif /* PAIR_DISTANCE_HISTOGRAM_H_ */
@@ -0,0 +1,239 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Minimal helpers to distribute analyzer work onto std::thread workers
+ * @details runOnThreads() and parallelFor() start their workers for every call
+ * and join them before the call returns. The analyzers use them for work of
+ * milliseconds to minutes per frame, where the thread start-up is negligible.
+ * ThreadPool keeps its workers alive between calls for analyzers whose work
+ * per frame is only some microseconds. An exception thrown by a task is
+ * rethrown in the calling thread.
+ * */
+/*****************************************************************************/
+
+#ifndef PARALLEL_TASKS_H_
+#define PARALLEL_TASKS_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+namespace ParallelTasks
+{
+	//! number of hardware threads, at least 1
+	inline uint32_t getDefaultNumThreads()
+	{
+		unsigned int n(std::thread::hardware_concurrency());
+		return (n==0) ? 1 : n;
+	}
+
+	//! largest number of threads accepted by parseNumThreads()
+	static const uint32_t maxNumThreads=4096;
+
+	/**
+	 * @brief number of threads given on the command line
+	 * @throw std::runtime_error unless text is an integer in [1,maxNumThreads]
+	 */
+	inline uint32_t parseNumThreads(const char* text)
+	{
+		char* end(0);
+		const long n(std::strtol(text,&end,10));
+		if(end==text || *end!='\0' || n<1 || n>long(maxNumThreads))
+			throw std::runtime_error("number of threads must be an integer from 1 to "+std::to_string(maxNumThreads)+", got \""+std::string(text)+"\"");
+		return uint32_t(n);
+	}
+
+	/**
+	 * @brief calls task(threadId) for threadId in [0,numThreads)
+	 * @details threadId 0 runs on the calling thread
+	 */
+	template<class Task>
+	void runOnThreads(uint32_t numThreads, Task task)
+	{
+		if(numThreads<=1){
+			task(uint32_t(0));
+			return;
+		}
+
+		std::vector<std::exception_ptr> errors(numThreads);
+		std::vector<std::thread> workers;
+		workers.reserve(numThreads-1);
+		for(uint32_t t=1;t<numThreads;t++){
+			workers.push_back(std::thread([&task,&errors,t](){
+				try{ task(t); }
+				catch(...){ errors[t]=std::current_exception(); }
+			}));
+		}
+		try{ task(uint32_t(0)); }
+		catch(...){ errors[0]=std::current_exception(); }
+
+		for(size_t t=0;t<workers.size();t++)
+			workers[t].join();
+		for(uint32_t t=0;t<numThreads;t++)
+			if(errors[t])
+				std::rethrow_exception(errors[t]);
+	}
+
+	/**
+	 * @brief calls task(item, threadId) for every item in [0,numItems)
+	 * @details items are handed out one by one, so items of different cost are balanced
+	 */
+	template<class Task>
+	void parallelFor(size_t numItems, uint32_t numThreads, Task task)
+	{
+		std::atomic<size_t> nextItem(0);
+		runOnThreads(numThreads,[&](uint32_t threadId){
+			for(size_t item=nextItem++; item<numItems; item=nextItem++)
+				task(item,threadId);
+		});
+	}
+
+	/**
+	 * @class ThreadPool
+	 * @brief numThreads-1 persistent workers plus the calling thread
+	 * @details The workers wait on a condition variable between calls, so a
+	 * call costs one wake-up per worker instead of a thread start and join.
+	 * Calls must not be nested or issued from several threads at once.
+	 */
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(uint32_t numThreads_=1)
+			: numThreads(1), generation(0), numRunning(0), stopping(false)
+		{
+			resize(numThreads_);
+		}
+
+		~ThreadPool() {stop();}
+
+		//! joins the current workers and starts numThreads_-1 new ones
+		void resize(uint32_t numThreads_)
+		{
+			stop();
+			numThreads=(numThreads_==0) ? 1 : numThreads_;
+			stopping=false;
+			errors.assign(numThreads,std::exception_ptr());
+			workers.reserve(numThreads-1);
+			for(uint32_t t=1;t<numThreads;t++)
+				workers.push_back(std::thread(&ThreadPool::work,this,t,generation));
+		}
+
+		uint32_t size() const {return numThreads;}
+
+		/**
+		 * @brief calls task(threadId) for threadId in [0,numThreads)
+		 * @details threadId 0 runs on the calling thread
+		 */
+		template<class Task>
+		void run(Task task)
+		{
+			if(numThreads<=1){
+				task(uint32_t(0));
+				return;
+			}
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				job=std::function<void(uint32_t)>(task);
+				numRunning=numThreads-1;
+				generation++;
+			}
+			start.notify_all();
+
+			try{ task(uint32_t(0)); }
+			catch(...){ errors[0]=std::current_exception(); }
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while(numRunning>0)
+					done.wait(lock);
+				job=std::function<void(uint32_t)>();
+			}
+			for(uint32_t t=0;t<numThreads;t++){
+				if(errors[t]){
+					std::exception_ptr error(errors[t]);
+					std::fill(errors.begin(),errors.end(),std::exception_ptr());
+					std::rethrow_exception(error);
+				}
+			}
+		}
+
+		/**
+		 * @brief calls task(item, threadId) for every item in [0,numItems)
+		 * @details items are handed out one by one, workers beyond numItems return at once
+		 */
+		template<class Task>
+		void parallelFor(size_t numItems, Task task)
+		{
+			std::atomic<size_t> nextItem(0);
+			run([&](uint32_t threadId){
+				if(threadId>=numItems)
+					return;
+				for(size_t item=nextItem++; item<numItems; item=nextItem++)
+					task(item,threadId);
+			});
+		}
+
+	private:
+		ThreadPool(const ThreadPool&);
+		ThreadPool& operator=(const ThreadPool&);
+
+		void stop()
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				stopping=true;
+			}
+			start.notify_all();
+			for(size_t t=0;t<workers.size();t++)
+				workers[t].join();
+			workers.clear();
+		}
+
+		void work(uint32_t threadId, uint64_t seenGeneration)
+		{
+			for(;;){
+				std::function<void(uint32_t)>* task;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					while(!stopping && generation==seenGeneration)
+						start.wait(lock);
+					if(stopping)
+						return;
+					seenGeneration=generation;
+					task=&job;
+				}
+
+				try{ (*task)(threadId); }
+				catch(...){ errors[threadId]=std::current_exception(); }
+
+				std::unique_lock<std::mutex> lock(mutex);
+				if(--numRunning==0)
+					done.notify_one();
+			}
+		}
+
+		uint32_t numThreads;
+		std::vector<std::thread> workers;
+		std::vector<std::exception_ptr> errors;
+
+		std::mutex mutex;
+		std::condition_variable start;
+		std::condition_variable done;
+		std::function<void(uint32_t)> job;
+		uint64_t generation;
+		uint32_t numRunning;
+		bool stopping;
+	};
+}
+
+#endif /* PARALLEL_TASKS_H_ */
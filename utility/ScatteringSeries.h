@@ -0,0 +1,240 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Binary time series of the per-frame scattering sums
+ * @details The file starts with a header
+ *   char[8]  "SQSERIES"
+ *   uint32   version (2)
+ *   uint32   number of q bins B
+ *   uint32   averaged quantity: 0 structure factor S(q), 1 form factor P(q)
+ *   uint32   number of partial structure factors P
+ *   double   normalization of S(q) (number of scatterers, 1 for form factors)
+ *   double   q[B]
+ *   P times  int32 tag a, int32 tag b, double normalization sqrt(N_a N_b)
+ * followed by one record per analysed frame
+ *   uint64   age of the configuration
+ *   double   sum of |C_q|^2 [B]
+ *   double   number of samples [B]
+ *   double   sum of Re(C_a conj(C_b)) [P][B]
+ * Version 1 files have no partial structure factors: the header lacks P and
+ * the pair list, the records lack the partial sums. All values are stored in
+ * the byte order of the writing machine. The records are handed to the disk
+ * in the blocks of the BackgroundFileWriter, and after the last record that
+ * completes the flush interval of the writer, so a killed analysis loses at
+ * most the records of one block or one flush interval. The file is only
+ * appended to, so every prefix that ends on a record border is a valid series
+ * and a partly written last record is ignored by the reader.
+ * */
+/*****************************************************************************/
+
+#ifndef SCATTERING_SERIES_H_
+#define SCATTERING_SERIES_H_
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "BackgroundFileWriter.h"
+
+namespace ScatteringSeries
+{
+	const char magic[8]={'S','Q','S','E','R','I','E','S'};
+	const uint32_t version(2);
+
+	//! quantity stored in the series, only used for the column name
+	enum Quantity {STRUCTURE_FACTOR=0, FORM_FACTOR=1};
+
+	//! pair of attribute tags of a partial structure factor S_ab
+	struct PartialPair {
+		int32_t tagA;
+		int32_t tagB;
+		//! sqrt(N_a N_b)
+		double normalization;
+	};
+
+	//! one record of the series
+	struct Frame {
+		uint64_t age;
+		std::vector<double> squaredAbsC_q;
+		std::vector<double> elements;
+		//! one array of B values per partial pair of the header
+		std::vector< std::vector<double> > partialC_q;
+	};
+
+	//! writes the header of a series with the absolute values q, the normalization of S(q) and the pairs of the partial structure factors
+	inline void writeHeader(BackgroundFileWriter& writer, const std::vector<double>& q, double normalization, Quantity quantity=STRUCTURE_FACTOR,
+	                        const std::vector<PartialPair>& partials=std::vector<PartialPair>())
+	{
+		const uint32_t numBins(q.size());
+		const uint32_t quantityId(quantity);
+		const uint32_t numPartials(partials.size());
+		writer.write(magic,sizeof(magic));
+		writer.write(&version,sizeof(version));
+		writer.write(&numBins,sizeof(numBins));
+		writer.write(&quantityId,sizeof(quantityId));
+		writer.write(&numPartials,sizeof(numPartials));
+		writer.write(&normalization,sizeof(normalization));
+		writer.write(q.data(),q.size()*sizeof(double));
+		for(size_t p=0;p<partials.size();p++){
+			writer.write(&partials[p].tagA,sizeof(partials[p].tagA));
+			writer.write(&partials[p].tagB,sizeof(partials[p].tagB));
+			writer.write(&partials[p].normalization,sizeof(partials[p].normalization));
+		}
+	}
+
+	//! appends one frame, all arrays have one entry per q bin of the header
+	inline void writeFrame(BackgroundFileWriter& writer, uint64_t age, const std::vector<double>& squaredAbsC_q, const std::vector<double>& elements,
+	                       const std::vector< std::vector<double> >& partialC_q=std::vector< std::vector<double> >())
+	{
+		writer.write(&age,sizeof(age));
+		writer.write(squaredAbsC_q.data(),squaredAbsC_q.size()*sizeof(double));
+		writer.write(elements.data(),elements.size()*sizeof(double));
+		for(size_t p=0;p<partialC_q.size();p++)
+			writer.write(partialC_q[p].data(),partialC_q[p].size()*sizeof(double));
+		// a record border, the only place where an incomplete block may be handed over
+		writer.flushIfDue();
+	}
+
+	/*****************************************************************************/
+	/**
+	 * @class Reader
+	 * @brief sequential reader of a series file
+	 * */
+	/*****************************************************************************/
+	class Reader
+	{
+	public:
+		//! opens the file and reads the header
+		explicit Reader(const std::string& filename);
+
+		//! reads the next complete record, returns false at the end of the series
+		bool readFrame(Frame& frame);
+
+		const std::vector<double>& getQ() const {return q;}
+		const std::vector<PartialPair>& getPartials() const {return partials;}
+		double getNormalization() const {return normalization;}
+		Quantity getQuantity() const {return quantity;}
+
+	private:
+		std::ifstream file;
+		std::vector<double> q;
+		std::vector<PartialPair> partials;
+		double normalization;
+		Quantity quantity;
+	};
+
+	inline Reader::Reader(const std::string& filename):
+		file(filename.c_str(),std::ios::in | std::ios::binary),
+		normalization(1.0),
+		quantity(STRUCTURE_FACTOR)
+	{
+		if(!file)
+			throw std::runtime_error("ScatteringSeries::Reader: cannot open "+filename);
+
+		char fileMagic[8];
+		uint32_t fileVersion(0), numBins(0), quantityId(0), numPartials(0);
+		file.read(fileMagic,sizeof(fileMagic));
+		file.read(reinterpret_cast<char*>(&fileVersion),sizeof(fileVersion));
+		if(!file || std::memcmp(fileMagic,magic,sizeof(magic))!=0)
+			throw std::runtime_error("ScatteringSeries::Reader: "+filename+" is not a scattering series");
+		if(fileVersion!=1 && fileVersion!=version)
+			throw std::runtime_error("ScatteringSeries::Reader: unsupported version of "+filename);
+		file.read(reinterpret_cast<char*>(&numBins),sizeof(numBins));
+		file.read(reinterpret_cast<char*>(&quantityId),sizeof(quantityId));
+		if(fileVersion>=2)
+			file.read(reinterpret_cast<char*>(&numPartials),sizeof(numPartials));
+		file.read(reinterpret_cast<char*>(&normalization),sizeof(normalization));
+		if(!file)
+			throw std::runtime_error("ScatteringSeries::Reader: incomplete header in "+filename);
+		quantity=(quantityId==FORM_FACTOR) ? FORM_FACTOR : STRUCTURE_FACTOR;
+
+		q.resize(numBins);
+		file.read(reinterpret_cast<char*>(q.data()),numBins*sizeof(double));
+		partials.resize(numPartials);
+		for(size_t p=0;p<partials.size();p++){
+			file.read(reinterpret_cast<char*>(&partials[p].tagA),sizeof(partials[p].tagA));
+			file.read(reinterpret_cast<char*>(&partials[p].tagB),sizeof(partials[p].tagB));
+			file.read(reinterpret_cast<char*>(&partials[p].normalization),sizeof(partials[p].normalization));
+		}
+		if(!file)
+			throw std::runtime_error("ScatteringSeries::Reader: incomplete header in "+filename);
+	}
+
+	inline bool Reader::readFrame(Frame& frame)
+	{
+		frame.squaredAbsC_q.resize(q.size());
+		frame.elements.resize(q.size());
+		file.read(reinterpret_cast<char*>(&frame.age),sizeof(frame.age));
+		file.read(reinterpret_cast<char*>(frame.squaredAbsC_q.data()),q.size()*sizeof(double));
+		file.read(reinterpret_cast<char*>(frame.elements.data()),q.size()*sizeof(double));
+		frame.partialC_q.resize(partials.size());
+		for(size_t p=0;p<partials.size();p++){
+			frame.partialC_q[p].resize(q.size());
+			file.read(reinterpret_cast<char*>(frame.partialC_q[p].data()),q.size()*sizeof(double));
+		}
+		return bool(file);
+	}
+
+	/**
+	 * @brief writes the averaged scattering function of the frames of a series
+	 * @details Frames with an age of at most minAge and all frames after the
+	 * first maxFrames are left out (maxFrames=0 takes all). Like in the
+	 * analyzer, the mean of every frame has the weight 1 independent of its
+	 * number of samples. The output has the
+	 * format of the _ScatteringFct.dat file of the scattering analyzer,
+	 * including the columns of the partial structure factors.
+	 * @return number of averaged frames
+	 */
+	inline uint64_t writeAverage(const std::string& seriesFilename, const std::string& outputFilename, uint64_t minAge=0, uint64_t maxFrames=0)
+	{
+		Reader reader(seriesFilename);
+		const std::vector<double>& q(reader.getQ());
+		std::vector<double> squaredAbsC_q(q.size(),0.0);
+		std::vector<double> frames(q.size(),0.0);
+		std::vector<double> elements(q.size(),0.0);
+		const std::vector<PartialPair>& partials(reader.getPartials());
+		std::vector< std::vector<double> > partialC_q(partials.size());
+		for(size_t p=0;p<partials.size();p++)
+			partialC_q[p].assign(q.size(),0.0);
+
+		Frame frame;
+		uint64_t numFrames(0);
+		while((maxFrames==0 || numFrames<maxFrames) && reader.readFrame(frame)){
+			if(frame.age<=minAge && minAge>0)
+				continue;
+			for(size_t j=0;j<q.size();j++){
+				if(frame.elements[j]==0.0)
+					continue;
+				squaredAbsC_q[j]+=frame.squaredAbsC_q[j]/frame.elements[j];
+				frames[j]+=1.0;
+				elements[j]+=frame.elements[j];
+				for(size_t p=0;p<partials.size();p++)
+					partialC_q[p][j]+=frame.partialC_q[p][j]/frame.elements[j];
+			}
+			numFrames++;
+		}
+
+		std::ofstream output(outputFilename.c_str(),std::ios::out);
+		if(!output)
+			throw std::runtime_error("ScatteringSeries::writeAverage: cannot open "+outputFilename);
+		output << "# Molecular Scattering Function\n"
+		<< ((reader.getQuantity()==FORM_FACTOR) ? "# q    P(q)   samples" : "# q    S(q)   samples");
+		for(size_t p=0;p<partials.size();p++)
+			output << "   S_" << partials[p].tagA << "_" << partials[p].tagB << "(q)";
+		output << std::endl;
+		for(size_t j=0;j<q.size();j++){
+			if(frames[j]==0.0)
+				continue;
+			output << q[j] << " " << squaredAbsC_q[j]/(frames[j]*reader.getNormalization()) << " " << elements[j];
+			for(size_t p=0;p<partials.size();p++)
+				output << " " << partialC_q[p][j]/(frames[j]*partials[p].normalization);
+			output << std::endl;
+		}
+		return numFrames;
+	}
+}
+
+#endif /* SCATTERING_SERIES_H_ */
@@ -0,0 +1,241 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief Incremental unwrapping of periodic lattice coordinates between frames
+ * @details The first frame is unwrapped along the bonds with minimum image
+ * vectors (MoleculeIndex). For every following frame only the displacement of
+ * each monomer since the last frame is folded into the box, so a monomer that
+ * crosses a periodic border changes its image flag and the unwrapped position
+ * follows in O(1). This is only right if no monomer moves by half a box length
+ * or more between two updates, which fails for sparse frames and for
+ * coordinates that are already unwrapped (as written by LeMonADE) whenever a
+ * monomer moves that far. Therefore every update checks the bonds of the
+ * spanning tree of each molecule against their minimum image vectors and
+ * unwraps a molecule with a broken bond again along its bonds, keeping the
+ * image of its root. Vectors within a molecule are thus always correct; only
+ * the absolute position of a repaired molecule may be off by box lengths.
+ * The update touches every monomer and every bond once. With a ThreadPool the
+ * monomers and the molecules are split into blocks on its threads; the
+ * blocks are independent, so the result does not depend on the threads.
+ * */
+/*****************************************************************************/
+
+#ifndef UNWRAPPED_COORDINATES_H_
+#define UNWRAPPED_COORDINATES_H_
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include <stdint.h>
+
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "MoleculeIndex.h"
+#include "ParallelTasks.h"
+
+/*****************************************************************************/
+/**
+ * @class UnwrappedCoordinates
+ * @brief image flags and last raw positions of all monomers
+ * */
+/*****************************************************************************/
+class UnwrappedCoordinates
+{
+public:
+	UnwrappedCoordinates():initialized(false),numRepairs(0){}
+
+	//! unwraps the current frame along the bonds of index and resets the image flags
+	template<class IngredientsType>
+	void initialize(const IngredientsType& ingredients, const MoleculeIndex& index);
+
+	//! follows the displacements since the last call of initialize() or update() and repairs broken bonds
+	template<class IngredientsType>
+	void update(const IngredientsType& ingredients, const MoleculeIndex& index);
+
+	//! update() with blocks of monomers and molecules distributed onto the threads of pool
+	template<class IngredientsType>
+	void update(const IngredientsType& ingredients, const MoleculeIndex& index, ParallelTasks::ThreadPool& pool);
+
+	bool isInitialized() const {return initialized;}
+
+	size_t size() const {return rawX.size();}
+
+	//! number of molecules unwrapped again along the bonds by update() since initialize()
+	uint64_t getNumRepairs() const {return numRepairs;}
+
+	//! unwrapped position of monomer i in the last frame
+	VectorInt3 getPosition(size_t i) const
+	{
+		return VectorInt3(rawX[i]+imageX[i]*box[0], rawY[i]+imageY[i]*box[1], rawZ[i]+imageZ[i]*box[2]);
+	}
+
+private:
+	bool initialized;
+	uint64_t numRepairs;
+	int32_t box[3];
+	bool periodic[3];
+
+	//! positions of the last frame as stored in the molecules
+	std::vector<int32_t> rawX, rawY, rawZ;
+
+	//! number of box lengths to add to the raw positions
+	std::vector<int32_t> imageX, imageY, imageZ;
+
+	//! monomers and molecules per work item of the parallel update
+	enum {MONOMER_BLOCK=4096, MOLECULE_BLOCK=64};
+
+	//! image shift of a displacement on a periodic axis of length l
+	static int32_t imageShift(int32_t displacement, int32_t l)
+	{
+		return int32_t(std::floor(double(displacement)/double(l)+0.5));
+	}
+
+	//! true if the unwrapped vector from a to b equals the minimum image vector of the raw positions
+	bool isBondValid(uint32_t a, uint32_t b) const;
+
+	//! unwraps molecule m along its bonds, the root keeps its image
+	template<class IngredientsType>
+	void unwrapMolecule(const IngredientsType& ingredients, const MoleculeIndex& index, size_t m);
+
+	//! follows the displacements of the monomers [begin,end)
+	template<class IngredientsType>
+	void updateMonomers(const IngredientsType& ingredients, size_t begin, size_t end);
+
+	//! repairs the molecules [begin,end) with a broken bond, returns their number
+	template<class IngredientsType>
+	uint64_t repairMolecules(const IngredientsType& ingredients, const MoleculeIndex& index, size_t begin, size_t end);
+};
+
+template<class IngredientsType>
+void UnwrappedCoordinates::initialize(const IngredientsType& ingredients, const MoleculeIndex& index)
+{
+	const size_t numMonomers(ingredients.getMolecules().size());
+	box[0]=ingredients.getBoxX();
+	box[1]=ingredients.getBoxY();
+	box[2]=ingredients.getBoxZ();
+	periodic[0]=ingredients.isPeriodicX();
+	periodic[1]=ingredients.isPeriodicY();
+	periodic[2]=ingredients.isPeriodicZ();
+
+	rawX.resize(numMonomers);
+	rawY.resize(numMonomers);
+	rawZ.resize(numMonomers);
+	imageX.assign(numMonomers,0);
+	imageY.assign(numMonomers,0);
+	imageZ.assign(numMonomers,0);
+	for(size_t i=0;i<numMonomers;i++){
+		rawX[i]=ingredients.getMolecules()[i].getX();
+		rawY[i]=ingredients.getMolecules()[i].getY();
+		rawZ[i]=ingredients.getMolecules()[i].getZ();
+	}
+
+	for(size_t m=0;m<index.getNumMolecules();m++)
+		unwrapMolecule(ingredients,index,m);
+	numRepairs=0;
+	initialized=true;
+}
+
+template<class IngredientsType>
+void UnwrappedCoordinates::update(const IngredientsType& ingredients, const MoleculeIndex& index)
+{
+	const size_t numMonomers(ingredients.getMolecules().size());
+	if(numMonomers!=rawX.size())
+		throw std::runtime_error("UnwrappedCoordinates: number of monomers changed between frames");
+
+	updateMonomers(ingredients,0,numMonomers);
+	numRepairs+=repairMolecules(ingredients,index,0,index.getNumMolecules());
+}
+
+template<class IngredientsType>
+void UnwrappedCoordinates::update(const IngredientsType& ingredients, const MoleculeIndex& index, ParallelTasks::ThreadPool& pool)
+{
+	const size_t numMonomers(ingredients.getMolecules().size());
+	if(numMonomers!=rawX.size())
+		throw std::runtime_error("UnwrappedCoordinates: number of monomers changed between frames");
+
+	// all displacements are followed before any bond is checked
+	const size_t numMonomerBlocks((numMonomers+MONOMER_BLOCK-1)/MONOMER_BLOCK);
+	pool.parallelFor(numMonomerBlocks,[&](size_t block, uint32_t){
+		updateMonomers(ingredients,block*MONOMER_BLOCK,std::min(numMonomers,(block+1)*MONOMER_BLOCK));
+	});
+
+	// molecules are disjoint, a repair only writes the images of its own monomers
+	const size_t numMolecules(index.getNumMolecules());
+	const size_t numMoleculeBlocks((numMolecules+MOLECULE_BLOCK-1)/MOLECULE_BLOCK);
+	std::vector<uint64_t> repairs(pool.size(),0);
+	pool.parallelFor(numMoleculeBlocks,[&](size_t block, uint32_t threadId){
+		repairs[threadId]+=repairMolecules(ingredients,index,block*MOLECULE_BLOCK,std::min(numMolecules,(block+1)*MOLECULE_BLOCK));
+	});
+	for(size_t t=0;t<repairs.size();t++)
+		numRepairs+=repairs[t];
+}
+
+template<class IngredientsType>
+void UnwrappedCoordinates::updateMonomers(const IngredientsType& ingredients, size_t begin, size_t end)
+{
+	for(size_t i=begin;i<end;i++){
+		const int32_t x(ingredients.getMolecules()[i].getX());
+		const int32_t y(ingredients.getMolecules()[i].getY());
+		const int32_t z(ingredients.getMolecules()[i].getZ());
+		// a jump by about one box length is a crossing of the periodic border
+		if(periodic[0]) imageX[i]-=imageShift(x-rawX[i],box[0]);
+		if(periodic[1]) imageY[i]-=imageShift(y-rawY[i],box[1]);
+		if(periodic[2]) imageZ[i]-=imageShift(z-rawZ[i],box[2]);
+		rawX[i]=x;
+		rawY[i]=y;
+		rawZ[i]=z;
+	}
+}
+
+template<class IngredientsType>
+uint64_t UnwrappedCoordinates::repairMolecules(const IngredientsType& ingredients, const MoleculeIndex& index, size_t begin, size_t end)
+{
+	// a monomer that moved half a box length or more broke one of its bonds
+	uint64_t repaired(0);
+	for(size_t m=begin;m<end;m++){
+		const uint32_t* block(index.getMonomers(m));
+		for(size_t k=1;k<index.getMoleculeSize(m);k++){
+			if(!isBondValid(block[index.getParent(m,k)],block[k])){
+				unwrapMolecule(ingredients,index,m);
+				repaired++;
+				break;
+			}
+		}
+	}
+	return repaired;
+}
+
+inline bool UnwrappedCoordinates::isBondValid(uint32_t a, uint32_t b) const
+{
+	const int32_t raw[3]={rawX[b]-rawX[a], rawY[b]-rawY[a], rawZ[b]-rawZ[a]};
+	const int32_t unwrapped[3]={raw[0]+(imageX[b]-imageX[a])*box[0],
+	                            raw[1]+(imageY[b]-imageY[a])*box[1],
+	                            raw[2]+(imageZ[b]-imageZ[a])*box[2]};
+	for(int d=0;d<3;d++){
+		const int32_t minImage(periodic[d] ? raw[d]-imageShift(raw[d],box[d])*box[d] : raw[d]);
+		if(unwrapped[d]!=minImage)
+			return false;
+	}
+	return true;
+}
+
+template<class IngredientsType>
+void UnwrappedCoordinates::unwrapMolecule(const IngredientsType& ingredients, const MoleculeIndex& index, size_t m)
+{
+	const size_t size(index.getMoleculeSize(m));
+	std::vector<int32_t> x(size), y(size), z(size);
+	index.unwrap(ingredients,m,&x[0],&y[0],&z[0]);
+
+	// index.unwrap() places the root at its raw position
+	const uint32_t* block(index.getMonomers(m));
+	const int32_t rootImage[3]={imageX[block[0]], imageY[block[0]], imageZ[block[0]]};
+	for(size_t k=0;k<size;k++){
+		const uint32_t i(block[k]);
+		if(periodic[0]) imageX[i]=rootImage[0]+(x[k]-rawX[i])/box[0];
+		if(periodic[1]) imageY[i]=rootImage[1]+(y[k]-rawY[i])/box[1];
+		if(periodic[2]) imageZ[i]=rootImage[2]+(z[k]-rawZ[i])/box[2];
+	}
+}
+
+#endif /* UNWRAPPED_COORDINATES_H_ */
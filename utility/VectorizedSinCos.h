@@ -0,0 +1,412 @@
+/*****************************************************************************/
+/**
+ * @file
+ * @brief SIMD kernels for sums of cos and sin over an array of phases
+ * @details The kernels evaluate
+ *   sumCos = SUM_k cos(scale*phase[k]) and sumSin = SUM_k sin(scale*phase[k])
+ * with a Cody-Waite range reduction to [-pi/4,pi/4] and the minimax
+ * polynomials of the cephes library. The instruction set (AVX2, SSE2 or
+ * plain scalar code using std::cos/std::sin) is selected once at runtime.
+ * For |scale*phase| < 1e8 the single terms agree with std::cos/std::sin
+ * within a few ulp, so sums deviate from the scalar reference only by
+ * rounding in the accumulation (relative 1e-12 for 1e6 terms).
+ * The float overloads use the single precision cephes polynomials with twice
+ * the number of lanes. Their range reduction is accurate for |scale*phase|
+ * up to about 8192, so phases should be kept small (e.g. by centring the
+ * positions). Every lane accumulates with Kahan compensation and the lanes
+ * are added in double, so the error of the sums is dominated by the single
+ * terms (about 1e-7 times the phase) and does not grow with the length.
+ * */
+/*****************************************************************************/
+
+#ifndef VECTORIZED_SIN_COS_H_
+#define VECTORIZED_SIN_COS_H_
+
+#include <cmath>
+#include <cstddef>
+
+#include "CpuFeatures.h"
+
+namespace VectorizedSinCos
+{
+	// cephes constants for range reduction by pi/4 in extended precision
+	static const double FOPI = 1.27323954473516268615;
+	static const double DP1  = 7.85398125648498535156E-1;
+	static const double DP2  = 3.77489470793079817668E-8;
+	static const double DP3  = 2.69515142907905952645E-15;
+
+	// cephes minimax coefficients for sin and cos on [-pi/4,pi/4]
+	static const double S0 =  1.58962301576546568060E-10;
+	static const double S1 = -2.50507477628578072866E-8;
+	static const double S2 =  2.75573136213857245213E-6;
+	static const double S3 = -1.98412698295895385996E-4;
+	static const double S4 =  8.33333333332211858878E-3;
+	static const double S5 = -1.66666666666666307295E-1;
+
+	static const double C0 = -1.13585365213876817300E-11;
+	static const double C1 =  2.08757008419747316778E-9;
+	static const double C2 = -2.75573141792967388112E-7;
+	static const double C3 =  2.48015872888517045348E-5;
+	static const double C4 = -1.38888888888730564116E-3;
+	static const double C5 =  4.16666666666665929218E-2;
+
+	// single precision cephes constants (sinf, cosf)
+	static const float DP1F = 0.78515625f;
+	static const float DP2F = 2.4187564849853515625E-4f;
+	static const float DP3F = 3.77489497744594108E-8f;
+
+	static const float S0F = -1.9515295891E-4f;
+	static const float S1F =  8.3321608736E-3f;
+	static const float S2F = -1.6666654611E-1f;
+
+	static const float C0F =  2.443315711809948E-5f;
+	static const float C1F = -1.388731625493765E-3f;
+	static const float C2F =  4.166664568298827E-2f;
+
+	//! reference implementation, also used for the remainder of the SIMD loops
+	inline void sumSinCosScalar(const double* phase, size_t n, double scale, double& sumCos, double& sumSin)
+	{
+		double c=0.0;
+		double s=0.0;
+		for(size_t k=0;k<n;k++){
+			double x(scale*phase[k]);
+			c+=std::cos(x);
+			s+=std::sin(x);
+		}
+		sumCos=c;
+		sumSin=s;
+	}
+
+	//! reference implementation for float phases, the terms are added in double
+	inline void sumSinCosScalar(const float* phase, size_t n, float scale, double& sumCos, double& sumSin)
+	{
+		double c=0.0;
+		double s=0.0;
+		for(size_t k=0;k<n;k++){
+			float x(scale*phase[k]);
+			c+=std::cos(x);
+			s+=std::sin(x);
+		}
+		sumCos=c;
+		sumSin=s;
+	}
+
+#ifdef CPU_FEATURES_X86
+
+	//! sin and cos of two doubles with SSE2
+	inline void sinCosSSE2(__m128d x, __m128d& sinX, __m128d& cosX)
+	{
+		const __m128d signMask=_mm_set1_pd(-0.0);
+		const __m128i one=_mm_set1_epi32(1);
+		const __m128i two=_mm_set1_epi32(2);
+		const __m128i four=_mm_set1_epi32(4);
+
+		// sin is odd, cos is even: reduce the absolute value
+		__m128d sinSign=_mm_and_pd(x,signMask);
+		__m128d ax=_mm_andnot_pd(signMask,x);
+
+		// octant j (even) and its 64bit lane representation
+		__m128i j=_mm_cvttpd_epi32(_mm_mul_pd(ax,_mm_set1_pd(FOPI)));
+		j=_mm_and_si128(_mm_add_epi32(j,one),_mm_set1_epi32(~1));
+		__m128d y=_mm_cvtepi32_pd(j);
+		__m128i jLane=_mm_shuffle_epi32(j,_MM_SHUFFLE(1,1,0,0));
+
+		__m128d swapPoly=_mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(jLane,two),two));
+		sinSign=_mm_xor_pd(sinSign,_mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(jLane,four),61)));
+		__m128d cosSign=_mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(_mm_add_epi32(jLane,two),four),61));
+
+		// extended precision modular arithmetic
+		__m128d z=_mm_sub_pd(ax,_mm_mul_pd(y,_mm_set1_pd(DP1)));
+		z=_mm_sub_pd(z,_mm_mul_pd(y,_mm_set1_pd(DP2)));
+		z=_mm_sub_pd(z,_mm_mul_pd(y,_mm_set1_pd(DP3)));
+		__m128d zz=_mm_mul_pd(z,z);
+
+		__m128d ps=_mm_set1_pd(S0);
+		ps=_mm_add_pd(_mm_mul_pd(ps,zz),_mm_set1_pd(S1));
+		ps=_mm_add_pd(_mm_mul_pd(ps,zz),_mm_set1_pd(S2));
+		ps=_mm_add_pd(_mm_mul_pd(ps,zz),_mm_set1_pd(S3));
+		ps=_mm_add_pd(_mm_mul_pd(ps,zz),_mm_set1_pd(S4));
+		ps=_mm_add_pd(_mm_mul_pd(ps,zz),_mm_set1_pd(S5));
+		__m128d sinZ=_mm_add_pd(z,_mm_mul_pd(_mm_mul_pd(z,zz),ps));
+
+		__m128d pc=_mm_set1_pd(C0);
+		pc=_mm_add_pd(_mm_mul_pd(pc,zz),_mm_set1_pd(C1));
+		pc=_mm_add_pd(_mm_mul_pd(pc,zz),_mm_set1_pd(C2));
+		pc=_mm_add_pd(_mm_mul_pd(pc,zz),_mm_set1_pd(C3));
+		pc=_mm_add_pd(_mm_mul_pd(pc,zz),_mm_set1_pd(C4));
+		pc=_mm_add_pd(_mm_mul_pd(pc,zz),_mm_set1_pd(C5));
+		__m128d cosZ=_mm_add_pd(_mm_sub_pd(_mm_set1_pd(1.0),_mm_mul_pd(_mm_set1_pd(0.5),zz)),_mm_mul_pd(_mm_mul_pd(zz,zz),pc));
+
+		sinX=_mm_or_pd(_mm_and_pd(swapPoly,cosZ),_mm_andnot_pd(swapPoly,sinZ));
+		cosX=_mm_or_pd(_mm_and_pd(swapPoly,sinZ),_mm_andnot_pd(swapPoly,cosZ));
+		sinX=_mm_xor_pd(sinX,sinSign);
+		cosX=_mm_xor_pd(cosX,cosSign);
+	}
+
+	inline void sumSinCosSSE2(const double* phase, size_t n, double scale, double& sumCos, double& sumSin)
+	{
+		__m128d c=_mm_setzero_pd();
+		__m128d s=_mm_setzero_pd();
+		const __m128d vScale=_mm_set1_pd(scale);
+		size_t k=0;
+		for(;k+2<=n;k+=2){
+			__m128d sinX, cosX;
+			sinCosSSE2(_mm_mul_pd(vScale,_mm_loadu_pd(phase+k)),sinX,cosX);
+			c=_mm_add_pd(c,cosX);
+			s=_mm_add_pd(s,sinX);
+		}
+		double lanesC[2], lanesS[2];
+		_mm_storeu_pd(lanesC,c);
+		_mm_storeu_pd(lanesS,s);
+		double restC, restS;
+		sumSinCosScalar(phase+k,n-k,scale,restC,restS);
+		sumCos=lanesC[0]+lanesC[1]+restC;
+		sumSin=lanesS[0]+lanesS[1]+restS;
+	}
+
+	//! sin and cos of four floats with SSE2
+	inline void sinCosSSE2(__m128 x, __m128& sinX, __m128& cosX)
+	{
+		const __m128 signMask=_mm_set1_ps(-0.0f);
+		const __m128i two=_mm_set1_epi32(2);
+		const __m128i four=_mm_set1_epi32(4);
+
+		__m128 sinSign=_mm_and_ps(x,signMask);
+		__m128 ax=_mm_andnot_ps(signMask,x);
+
+		__m128i j=_mm_cvttps_epi32(_mm_mul_ps(ax,_mm_set1_ps(float(FOPI))));
+		j=_mm_and_si128(_mm_add_epi32(j,_mm_set1_epi32(1)),_mm_set1_epi32(~1));
+		__m128 y=_mm_cvtepi32_ps(j);
+
+		__m128 swapPoly=_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j,two),two));
+		sinSign=_mm_xor_ps(sinSign,_mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j,four),29)));
+		__m128 cosSign=_mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(j,two),four),29));
+
+		__m128 z=_mm_sub_ps(ax,_mm_mul_ps(y,_mm_set1_ps(DP1F)));
+		z=_mm_sub_ps(z,_mm_mul_ps(y,_mm_set1_ps(DP2F)));
+		z=_mm_sub_ps(z,_mm_mul_ps(y,_mm_set1_ps(DP3F)));
+		__m128 zz=_mm_mul_ps(z,z);
+
+		__m128 ps=_mm_set1_ps(S0F);
+		ps=_mm_add_ps(_mm_mul_ps(ps,zz),_mm_set1_ps(S1F));
+		ps=_mm_add_ps(_mm_mul_ps(ps,zz),_mm_set1_ps(S2F));
+		__m128 sinZ=_mm_add_ps(z,_mm_mul_ps(_mm_mul_ps(z,zz),ps));
+
+		__m128 pc=_mm_set1_ps(C0F);
+		pc=_mm_add_ps(_mm_mul_ps(pc,zz),_mm_set1_ps(C1F));
+		pc=_mm_add_ps(_mm_mul_ps(pc,zz),_mm_set1_ps(C2F));
+		__m128 cosZ=_mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f),_mm_mul_ps(_mm_set1_ps(0.5f),zz)),_mm_mul_ps(_mm_mul_ps(zz,zz),pc));
+
+		sinX=_mm_or_ps(_mm_and_ps(swapPoly,cosZ),_mm_andnot_ps(swapPoly,sinZ));
+		cosX=_mm_or_ps(_mm_and_ps(swapPoly,sinZ),_mm_andnot_ps(swapPoly,cosZ));
+		sinX=_mm_xor_ps(sinX,sinSign);
+		cosX=_mm_xor_ps(cosX,cosSign);
+	}
+
+	inline void sumSinCosSSE2(const float* phase, size_t n, float scale, double& sumCos, double& sumSin)
+	{
+		// Kahan summation per lane: sum and lost low order part
+		__m128 c=_mm_setzero_ps(), cLost=_mm_setzero_ps();
+		__m128 s=_mm_setzero_ps(), sLost=_mm_setzero_ps();
+		const __m128 vScale=_mm_set1_ps(scale);
+		size_t k=0;
+		for(;k+4<=n;k+=4){
+			__m128 sinX, cosX;
+			sinCosSSE2(_mm_mul_ps(vScale,_mm_loadu_ps(phase+k)),sinX,cosX);
+			__m128 yc=_mm_sub_ps(cosX,cLost);
+			__m128 tc=_mm_add_ps(c,yc);
+			cLost=_mm_sub_ps(_mm_sub_ps(tc,c),yc);
+			c=tc;
+			__m128 ys=_mm_sub_ps(sinX,sLost);
+			__m128 ts=_mm_add_ps(s,ys);
+			sLost=_mm_sub_ps(_mm_sub_ps(ts,s),ys);
+			s=ts;
+		}
+		float lanesC[4], lanesCLost[4], lanesS[4], lanesSLost[4];
+		_mm_storeu_ps(lanesC,c);
+		_mm_storeu_ps(lanesCLost,cLost);
+		_mm_storeu_ps(lanesS,s);
+		_mm_storeu_ps(lanesSLost,sLost);
+		double restC, restS;
+		sumSinCosScalar(phase+k,n-k,scale,restC,restS);
+		sumCos=restC;
+		sumSin=restS;
+		for(int l=0;l<4;l++){
+			sumCos+=double(lanesC[l])-double(lanesCLost[l]);
+			sumSin+=double(lanesS[l])-double(lanesSLost[l]);
+		}
+	}
+
+	//! sin and cos of four doubles with AVX2
+	__attribute__((target("avx2")))
+	inline void sinCosAVX2(__m256d x, __m256d& sinX, __m256d& cosX)
+	{
+		const __m256d signMask=_mm256_set1_pd(-0.0);
+		const __m256i two=_mm256_set1_epi64x(2);
+		const __m256i four=_mm256_set1_epi64x(4);
+
+		__m256d sinSign=_mm256_and_pd(x,signMask);
+		__m256d ax=_mm256_andnot_pd(signMask,x);
+
+		__m128i j=_mm256_cvttpd_epi32(_mm256_mul_pd(ax,_mm256_set1_pd(FOPI)));
+		j=_mm_and_si128(_mm_add_epi32(j,_mm_set1_epi32(1)),_mm_set1_epi32(~1));
+		__m256d y=_mm256_cvtepi32_pd(j);
+		__m256i jLane=_mm256_cvtepi32_epi64(j);
+
+		__m256d swapPoly=_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(jLane,two),two));
+		sinSign=_mm256_xor_pd(sinSign,_mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(jLane,four),61)));
+		__m256d cosSign=_mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(_mm256_add_epi64(jLane,two),four),61));
+
+		__m256d z=_mm256_sub_pd(ax,_mm256_mul_pd(y,_mm256_set1_pd(DP1)));
+		z=_mm256_sub_pd(z,_mm256_mul_pd(y,_mm256_set1_pd(DP2)));
+		z=_mm256_sub_pd(z,_mm256_mul_pd(y,_mm256_set1_pd(DP3)));
+		__m256d zz=_mm256_mul_pd(z,z);
+
+		__m256d ps=_mm256_set1_pd(S0);
+		ps=_mm256_add_pd(_mm256_mul_pd(ps,zz),_mm256_set1_pd(S1));
+		ps=_mm256_add_pd(_mm256_mul_pd(ps,zz),_mm256_set1_pd(S2));
+		ps=_mm256_add_pd(_mm256_mul_pd(ps,zz),_mm256_set1_pd(S3));
+		ps=_mm256_add_pd(_mm256_mul_pd(ps,zz),_mm256_set1_pd(S4));
+		ps=_mm256_add_pd(_mm256_mul_pd(ps,zz),_mm256_set1_pd(S5));
+		__m256d sinZ=_mm256_add_pd(z,_mm256_mul_pd(_mm256_mul_pd(z,zz),ps));
+
+		__m256d pc=_mm256_set1_pd(C0);
+		pc=_mm256_add_pd(_mm256_mul_pd(pc,zz),_mm256_set1_pd(C1));
+		pc=_mm256_add_pd(_mm256_mul_pd(pc,zz),_mm256_set1_pd(C2));
+		pc=_mm256_add_pd(_mm256_mul_pd(pc,zz),_mm256_set1_pd(C3));
+		pc=_mm256_add_pd(_mm256_mul_pd(pc,zz),_mm256_set1_pd(C4));
+		pc=_mm256_add_pd(_mm256_mul_pd(pc,zz),_mm256_set1_pd(C5));
+		__m256d cosZ=_mm256_add_pd(_mm256_sub_pd(_mm256_set1_pd(1.0),_mm256_mul_pd(_mm256_set1_pd(0.5),zz)),_mm256_mul_pd(_mm256_mul_pd(zz,zz),pc));
+
+		sinX=_mm256_xor_pd(_mm256_blendv_pd(sinZ,cosZ,swapPoly),sinSign);
+		cosX=_mm256_xor_pd(_mm256_blendv_pd(cosZ,sinZ,swapPoly),cosSign);
+	}
+
+	__attribute__((target("avx2")))
+	inline void sumSinCosAVX2(const double* phase, size_t n, double scale, double& sumCos, double& sumSin)
+	{
+		__m256d c=_mm256_setzero_pd();
+		__m256d s=_mm256_setzero_pd();
+		const __m256d vScale=_mm256_set1_pd(scale);
+		size_t k=0;
+		for(;k+4<=n;k+=4){
+			__m256d sinX, cosX;
+			sinCosAVX2(_mm256_mul_pd(vScale,_mm256_loadu_pd(phase+k)),sinX,cosX);
+			c=_mm256_add_pd(c,cosX);
+			s=_mm256_add_pd(s,sinX);
+		}
+		double lanesC[4], lanesS[4];
+		_mm256_storeu_pd(lanesC,c);
+		_mm256_storeu_pd(lanesS,s);
+		double restC, restS;
+		sumSinCosScalar(phase+k,n-k,scale,restC,restS);
+		sumCos=(lanesC[0]+lanesC[1])+(lanesC[2]+lanesC[3])+restC;
+		sumSin=(lanesS[0]+lanesS[1])+(lanesS[2]+lanesS[3])+restS;
+	}
+
+	//! sin and cos of eight floats with AVX2
+	__attribute__((target("avx2")))
+	inline void sinCosAVX2(__m256 x, __m256& sinX, __m256& cosX)
+	{
+		const __m256 signMask=_mm256_set1_ps(-0.0f);
+		const __m256i two=_mm256_set1_epi32(2);
+		const __m256i four=_mm256_set1_epi32(4);
+
+		__m256 sinSign=_mm256_and_ps(x,signMask);
+		__m256 ax=_mm256_andnot_ps(signMask,x);
+
+		__m256i j=_mm256_cvttps_epi32(_mm256_mul_ps(ax,_mm256_set1_ps(float(FOPI))));
+		j=_mm256_and_si256(_mm256_add_epi32(j,_mm256_set1_epi32(1)),_mm256_set1_epi32(~1));
+		__m256 y=_mm256_cvtepi32_ps(j);
+
+		__m256 swapPoly=_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j,two),two));
+		sinSign=_mm256_xor_ps(sinSign,_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j,four),29)));
+		__m256 cosSign=_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(j,two),four),29));
+
+		__m256 z=_mm256_sub_ps(ax,_mm256_mul_ps(y,_mm256_set1_ps(DP1F)));
+		z=_mm256_sub_ps(z,_mm256_mul_ps(y,_mm256_set1_ps(DP2F)));
+		z=_mm256_sub_ps(z,_mm256_mul_ps(y,_mm256_set1_ps(DP3F)));
+		__m256 zz=_mm256_mul_ps(z,z);
+
+		__m256 ps=_mm256_set1_ps(S0F);
+		ps=_mm256_add_ps(_mm256_mul_ps(ps,zz),_mm256_set1_ps(S1F));
+		ps=_mm256_add_ps(_mm256_mul_ps(ps,zz),_mm256_set1_ps(S2F));
+		__m256 sinZ=_mm256_add_ps(z,_mm256_mul_ps(_mm256_mul_ps(z,zz),ps));
+
+		__m256 pc=_mm256_set1_ps(C0F);
+		pc=_mm256_add_ps(_mm256_mul_ps(pc,zz),_mm256_set1_ps(C1F));
+		pc=_mm256_add_ps(_mm256_mul_ps(pc,zz),_mm256_set1_ps(C2F));
+		__m256 cosZ=_mm256_add_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f),_mm256_mul_ps(_mm256_set1_ps(0.5f),zz)),_mm256_mul_ps(_mm256_mul_ps(zz,zz),pc));
+
+		sinX=_mm256_xor_ps(_mm256_blendv_ps(sinZ,cosZ,swapPoly),sinSign);
+		cosX=_mm256_xor_ps(_mm256_blendv_ps(cosZ,sinZ,swapPoly),cosSign);
+	}
+
+	__attribute__((target("avx2")))
+	inline void sumSinCosAVX2(const float* phase, size_t n, float scale, double& sumCos, double& sumSin)
+	{
+		__m256 c=_mm256_setzero_ps(), cLost=_mm256_setzero_ps();
+		__m256 s=_mm256_setzero_ps(), sLost=_mm256_setzero_ps();
+		const __m256 vScale=_mm256_set1_ps(scale);
+		size_t k=0;
+		for(;k+8<=n;k+=8){
+			__m256 sinX, cosX;
+			sinCosAVX2(_mm256_mul_ps(vScale,_mm256_loadu_ps(phase+k)),sinX,cosX);
+			__m256 yc=_mm256_sub_ps(cosX,cLost);
+			__m256 tc=_mm256_add_ps(c,yc);
+			cLost=_mm256_sub_ps(_mm256_sub_ps(tc,c),yc);
+			c=tc;
+			__m256 ys=_mm256_sub_ps(sinX,sLost);
+			__m256 ts=_mm256_add_ps(s,ys);
+			sLost=_mm256_sub_ps(_mm256_sub_ps(ts,s),ys);
+			s=ts;
+		}
+		float lanesC[8], lanesCLost[8], lanesS[8], lanesSLost[8];
+		_mm256_storeu_ps(lanesC,c);
+		_mm256_storeu_ps(lanesCLost,cLost);
+		_mm256_storeu_ps(lanesS,s);
+		_mm256_storeu_ps(lanesSLost,sLost);
+		double restC, restS;
+		sumSinCosScalar(phase+k,n-k,scale,restC,restS);
+		sumCos=restC;
+		sumSin=restS;
+		for(int l=0;l<8;l++){
+			sumCos+=double(lanesC[l])-double(lanesCLost[l]);
+			sumSin+=double(lanesS[l])-double(lanesSLost[l]);
+		}
+	}
+
+#endif /* CPU_FEATURES_X86 */
+
+	/**
+	 * @brief sums cos(scale*phase[k]) and sin(scale*phase[k]) over k<n
+	 * @param phase array of n phases (no alignment requirement)
+	 * @param scale common factor applied to every phase
+	 */
+	inline void sumSinCos(const double* phase, size_t n, double scale, double& sumCos, double& sumSin)
+	{
+		switch(CpuFeatures::getInstructionSet())
+		{
+#ifdef CPU_FEATURES_X86
+			case CpuFeatures::AVX2: sumSinCosAVX2(phase,n,scale,sumCos,sumSin); return;
+			case CpuFeatures::SSE2: sumSinCosSSE2(phase,n,scale,sumCos,sumSin); return;
+#endif
+			default: sumSinCosScalar(phase,n,scale,sumCos,sumSin); return;
+		}
+	}
+
+	//! single precision version of sumSinCos, the sums are returned in double
+	inline void sumSinCos(const float* phase, size_t n, float scale, double& sumCos, double& sumSin)
+	{
+		switch(CpuFeatures::getInstructionSet())
+		{
+#ifdef CPU_FEATURES_X86
+			case CpuFeatures::AVX2: sumSinCosAVX2(phase,n,scale,sumCos,sumSin); return;
+			case CpuFeatures::SSE2: sumSinCosSSE2(phase,n,scale,sumCos,sumSin); return;
+#endif
+			default: sumSinCosScalar(phase,n,scale,sumCos,sumSin); return;
+		}
+	}
+}
+
+#endif /* VECTORIZED_SIN_COS_H_ */